@@ -0,0 +1,572 @@
+// Windowless benchmark: casts a scripted camera path over fixed and generated
+// maps with every caster and packet backend, at several view widths, and
+// reports the cost per ray, cast-time percentiles and peak RSS per case.
+// Only CastView is timed; the headless mode of main12 covers whole frames.
+// With --golden it instead checks golden frame hashes (see golden.h) without
+// raylib, once per file and with the settings each file was written with.
+//
+// Build: cc -O2 -pthread bench.c $(ls *.c | grep -v '^main' | grep -v '^bench.c$') -lm -o bench
+#include "clock.h"
+#include "golden.h"
+#include "headless.h"
+#include "los.h"
+#include "mapfile.h"
+#include "raycast.h"
+#include "raypacket.h"
+#include "render.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#define MAX_SCENARIOS 8
+#define MAX_WIDTHS 8
+#define MAX_BASELINE 512
+#define MAX_GOLDEN 16
+
+typedef struct {
+    const char* name;
+    const char* path; // NULL: generated, or the built-in map when genWidth is 0
+    int genWidth;
+    int genHeight;
+    float density;
+    float viewDistance;
+} Scenario;
+
+// One caster, or the packet caster with one SIMD backend
+typedef struct {
+    CasterKind caster;
+    PacketKernel kernel;
+} Backend;
+
+typedef struct {
+    const char* map;
+    int width;
+    int rays;
+    const char* caster;
+    const char* backend;
+    int threads;
+    int frames;
+    double nsPerRay;
+    double raysPerSecond;
+    double p50Ms;
+    double p99Ms;
+    double spreadPercent; // Spread of the per-repeat medians
+    long peakRssKb;
+} BenchResult;
+
+typedef struct {
+    char key[160];
+    double nsPerRay;
+} BaselineEntry;
+
+static const Scenario defaultScenarios[] = {
+    {"builtin", NULL, 0, 0, 0.0f, MAX_RAY_DISTANCE},
+    {"sparse512", NULL, 512, 512, 0.02f, 64.0f},
+    {"open2048", NULL, 2048, 2048, 0.002f, 128.0f},
+};
+
+static void PrintUsage(const char* program) {
+    printf("usage: %s [--frames N] [--warmup N] [--repeat N] [--threads N] [--pin] [--widths W,W,...]\n"
+           "          [--casters dda,march,packet,hier,field,fixed] [--map FILE] [--view-distance D] [--seed N]\n"
+           "          [--los QUERIES] [--csv FILE|-] [--json FILE|-] [--baseline FILE.csv] [--threshold PERCENT]\n"
+           "          [--golden FILE]... [--golden-update]\n",
+           program);
+}
+
+static int CompareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of a sorted array
+static double Percentile(const double* sorted, int count, double p) {
+    int rank = (int)ceil(p / 100.0 * count);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+// Linux lets the high-water mark be reset, so each case reports its own peak
+// rather than the largest one so far
+static void ResetPeakRss(void) {
+    FILE* file = fopen("/proc/self/clear_refs", "w");
+    if (!file) return;
+    fputs("5", file);
+    fclose(file);
+}
+
+static long GetPeakRssKb(void) {
+    FILE* file = fopen("/proc/self/status", "r");
+    if (file) {
+        char line[256];
+        long kb = -1;
+        while (fgets(line, sizeof(line), file)) {
+            if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) break;
+        }
+        fclose(file);
+        if (kb >= 0) return kb;
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Scripted camera: turns 3 degrees a frame and walks a quarter cell forward,
+// turning a right angle instead whenever the next cell is a wall. Depends only
+// on the map, so every backend sees the same views.
+static void AdvanceCamera(const Map* map, Player* player, int frame) {
+    player->angle = fmodf(player->angle + 3.0f, 360.0f);
+    if (frame % 45 == 0) {
+        // Every 45th frame snaps to an axis heading, exercising the prebuilt heading tables
+        player->angle = roundf(player->angle / 90.0f) * 90.0f;
+    }
+    float nextX = player->pos.x + 0.25f * cosf(player->angle * DEG2RAD);
+    float nextY = player->pos.y + 0.25f * sinf(player->angle * DEG2RAD);
+    if (MapIsSolid(map, (int)floorf(nextX + PLAYER_OFFSET), (int)floorf(nextY + PLAYER_OFFSET))) {
+        player->angle = fmodf(player->angle + 90.0f, 360.0f);
+    } else {
+        player->pos.x = nextX;
+        player->pos.y = nextY;
+    }
+}
+
+// Fills the timing fields of result from per-frame times, each repeat's
+// frames already sorted in place
+static void SummarizeTimes(double* times, double* medians, int frames, int repeat, int raysPerFrame,
+                           BenchResult* result) {
+    double total = 0;
+    for (int i = 0; i < frames * repeat; i++) total += times[i];
+    qsort(times, frames * repeat, sizeof(double), CompareDoubles);
+    qsort(medians, repeat, sizeof(double), CompareDoubles);
+
+    double p50 = Percentile(times, frames * repeat, 50.0);
+    result->rays = raysPerFrame;
+    result->frames = frames * repeat;
+    result->nsPerRay = p50 * 1e9 / raysPerFrame;
+    result->raysPerSecond = (double)raysPerFrame * frames * repeat / total;
+    result->p50Ms = p50 * 1000.0;
+    result->p99Ms = Percentile(times, frames * repeat, 99.0) * 1000.0;
+    result->spreadPercent = (medians[repeat - 1] - medians[0]) / medians[0] * 100.0;
+}
+
+static bool RunCase(const Level* level, const Scenario* scenario, int width, Backend backend, int frames, int warmup,
+                    int repeat, ThreadPool* pool, BenchResult* result) {
+    const Map* map = &level->map;
+    int numRays = GetViewRayCount(width, false);
+    RayTable table = {0};
+    RayHit* hits = malloc(sizeof(RayHit) * numRays);
+    double* times = malloc(sizeof(double) * frames * repeat);
+    double* medians = malloc(sizeof(double) * repeat);
+    if (!hits || !times || !medians || !RayTableInit(&table, numRays, FOV)) {
+        free(hits);
+        free(times);
+        free(medians);
+        return false;
+    }
+    if (backend.caster == CASTER_PACKET) SetPacketKernel(backend.kernel);
+
+    ResetPeakRss();
+    for (int r = 0; r < repeat; r++) {
+        Player player = {.pos = {(float)map->spawnX, (float)map->spawnY}, .angle = 0.0f, .speed = 0.0f};
+        for (int frame = 0; frame < warmup + frames; frame++) {
+            AdvanceCamera(map, &player, frame);
+            double start = GetMonotonicSeconds();
+            CastView(level, &player, &table, backend.caster, scenario->viewDistance, hits, pool);
+            double elapsed = GetMonotonicSeconds() - start;
+            if (frame >= warmup) times[r * frames + frame - warmup] = elapsed;
+        }
+        qsort(times + r * frames, frames, sizeof(double), CompareDoubles);
+        medians[r] = Percentile(times + r * frames, frames, 50.0);
+    }
+    *result = (BenchResult){
+        .map = scenario->name,
+        .width = width,
+        .caster = GetCasterName(backend.caster),
+        .backend = backend.caster == CASTER_PACKET ? GetPacketKernelName(backend.kernel) : "-",
+        .threads = ThreadPoolSize(pool),
+        .peakRssKb = GetPeakRssKb(),
+    };
+    SummarizeTimes(times, medians, frames, repeat, numRays, result);
+
+    RayTableFree(&table);
+    free(hits);
+    free(times);
+    free(medians);
+    return true;
+}
+
+// Line-of-sight batch: queries from random empty cells to points up to 24
+// cells away, answered queries-per-tick at a time. Reported with the query
+// count as the width and "los" as the caster.
+static bool RunLosCase(const Level* level, const Scenario* scenario, int queries, int frames, int warmup, int repeat,
+                       uint32_t seed, ThreadPool* pool, BenchResult* result) {
+    const Map* map = &level->map;
+    LosSegment* segments = malloc(sizeof(LosSegment) * queries);
+    LosResult* results = malloc(sizeof(LosResult) * queries);
+    double* times = malloc(sizeof(double) * frames * repeat);
+    double* medians = malloc(sizeof(double) * repeat);
+    if (!segments || !results || !times || !medians) {
+        free(segments);
+        free(results);
+        free(times);
+        free(medians);
+        return false;
+    }
+
+    uint32_t state = seed * 2654435761u + 1;
+    for (int i = 0; i < queries; i++) {
+        int x, y;
+        do {
+            state ^= state << 13, state ^= state >> 17, state ^= state << 5;
+            x = (int)(state % (uint32_t)map->width);
+            y = (int)((state >> 16) % (uint32_t)map->height);
+        } while (MapIsSolid(map, x, y));
+        state ^= state << 13, state ^= state >> 17, state ^= state << 5;
+        float angle = (state & 0xFFFF) * (2.0f * PI / 65536.0f);
+        float length = (state >> 16) * (24.0f / 65536.0f);
+        float fromX = x + 0.5f, fromY = y + 0.5f;
+        segments[i] = (LosSegment){fromX, fromY, fromX + length * cosf(angle), fromY + length * sinf(angle)};
+    }
+
+    ResetPeakRss();
+    for (int r = 0; r < repeat; r++) {
+        for (int frame = 0; frame < warmup + frames; frame++) {
+            double start = GetMonotonicSeconds();
+            QueryLineOfSight(map, segments, queries, results, pool);
+            double elapsed = GetMonotonicSeconds() - start;
+            if (frame >= warmup) times[r * frames + frame - warmup] = elapsed;
+        }
+        qsort(times + r * frames, frames, sizeof(double), CompareDoubles);
+        medians[r] = Percentile(times + r * frames, frames, 50.0);
+    }
+    *result = (BenchResult){
+        .map = scenario->name,
+        .width = queries,
+        .caster = "los",
+        .backend = GetPacketKernelName(GetPacketKernel()),
+        .threads = ThreadPoolSize(pool),
+        .peakRssKb = GetPeakRssKb(),
+    };
+    SummarizeTimes(times, medians, frames, repeat, queries, result);
+
+    free(segments);
+    free(results);
+    free(times);
+    free(medians);
+    return true;
+}
+
+static bool LoadScenario(Level* level, const Scenario* scenario, uint32_t seed) {
+    if (scenario->path) return MapLoadFile(&level->map, scenario->path);
+    if (scenario->genWidth > 0) {
+        return MapGenerateSparse(&level->map, scenario->genWidth, scenario->genHeight, scenario->density, seed);
+    }
+    return MapLoadDefault(&level->map);
+}
+
+static void PrintResult(FILE* log, const BenchResult* r) {
+    fprintf(log, "%-10s %5d %-7s %-7s %3d %10.2f %10.3f %9.4f %9.4f %6.1f%% %9ld\n", r->map, r->width, r->caster,
+            r->backend, r->threads, r->nsPerRay, r->raysPerSecond / 1e6, r->p50Ms, r->p99Ms, r->spreadPercent,
+            r->peakRssKb);
+}
+
+static void FormatKey(char* key, size_t size, const char* map, int width, const char* caster, const char* backend,
+                      int threads) {
+    snprintf(key, size, "%s,%d,%s,%s,%d", map, width, caster, backend, threads);
+}
+
+static void WriteCsv(FILE* file, const BenchResult* results, int count) {
+    fprintf(file, "map,width,rays,caster,backend,threads,frames,ns_per_ray,rays_per_sec,p50_ms,p99_ms,spread_pct,"
+                  "peak_rss_kb\n");
+    for (int i = 0; i < count; i++) {
+        const BenchResult* r = &results[i];
+        fprintf(file, "%s,%d,%d,%s,%s,%d,%d,%.3f,%.0f,%.4f,%.4f,%.2f,%ld\n", r->map, r->width, r->rays, r->caster,
+                r->backend, r->threads, r->frames, r->nsPerRay, r->raysPerSecond, r->p50Ms, r->p99Ms,
+                r->spreadPercent, r->peakRssKb);
+    }
+}
+
+static void WriteJson(FILE* file, const BenchResult* results, int count) {
+    fprintf(file, "[\n");
+    for (int i = 0; i < count; i++) {
+        const BenchResult* r = &results[i];
+        fprintf(file,
+                "  {\"map\": \"%s\", \"width\": %d, \"rays\": %d, \"caster\": \"%s\", \"backend\": \"%s\", "
+                "\"threads\": %d, \"frames\": %d, \"ns_per_ray\": %.3f, \"rays_per_sec\": %.0f, \"p50_ms\": %.4f, "
+                "\"p99_ms\": %.4f, \"spread_pct\": %.2f, \"peak_rss_kb\": %ld}%s\n",
+                r->map, r->width, r->rays, r->caster, r->backend, r->threads, r->frames, r->nsPerRay,
+                r->raysPerSecond, r->p50Ms, r->p99Ms, r->spreadPercent, r->peakRssKb, i + 1 < count ? "," : "");
+    }
+    fprintf(file, "]\n");
+}
+
+static bool WriteResults(const char* path, const BenchResult* results, int count, bool json) {
+    FILE* file = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return false;
+    }
+    if (json) {
+        WriteJson(file, results, count);
+    } else {
+        WriteCsv(file, results, count);
+    }
+    if (file != stdout) fclose(file);
+    return true;
+}
+
+// Reads the key columns and ns_per_ray back from a CSV written by an earlier run
+static int LoadBaseline(const char* path, BaselineEntry* entries, int capacity) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "cannot read baseline %s\n", path);
+        return -1;
+    }
+    char line[512];
+    int count = 0;
+    while (fgets(line, sizeof(line), file) && count < capacity) {
+        char map[64], caster[32], backend[32];
+        int width, rays, threads, frames;
+        double nsPerRay;
+        if (sscanf(line, "%63[^,],%d,%d,%31[^,],%31[^,],%d,%d,%lf", map, &width, &rays, caster, backend, &threads,
+                   &frames, &nsPerRay) != 8) {
+            continue; // Header
+        }
+        FormatKey(entries[count].key, sizeof(entries[count].key), map, width, caster, backend, threads);
+        entries[count].nsPerRay = nsPerRay;
+        count++;
+    }
+    fclose(file);
+    return count;
+}
+
+// Returns the number of cases slower than the baseline by more than threshold percent
+static int CompareBaseline(FILE* log, const BenchResult* results, int count, const BaselineEntry* baseline,
+                           int baselineCount, double threshold) {
+    int regressions = 0;
+    for (int i = 0; i < count; i++) {
+        const BenchResult* r = &results[i];
+        char key[160];
+        FormatKey(key, sizeof(key), r->map, r->width, r->caster, r->backend, r->threads);
+        for (int b = 0; b < baselineCount; b++) {
+            if (strcmp(key, baseline[b].key) != 0) continue;
+            double change = (r->nsPerRay - baseline[b].nsPerRay) / baseline[b].nsPerRay * 100.0;
+            if (change > threshold) {
+                fprintf(log, "REGRESSION %-40s %9.2f -> %9.2f ns/ray (%+.1f%%)\n", key, baseline[b].nsPerRay,
+                        r->nsPerRay, change);
+                regressions++;
+            }
+            break;
+        }
+    }
+    return regressions;
+}
+
+// Parses a comma-separated list of caster names into backends, expanding
+// packet into every SIMD kernel this CPU supports
+static int ParseBackends(const char* list, Backend* backends, int capacity) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", list);
+    PacketKernel best = SetPacketKernel(PACKET_KERNEL_COUNT);
+    int count = 0;
+    for (char* name = strtok(buffer, ","); name; name = strtok(NULL, ",")) {
+        CasterKind caster;
+        if (!ParseCasterName(name, &caster)) return -1;
+        if (caster != CASTER_PACKET) {
+            if (count < capacity) backends[count++] = (Backend){caster, PACKET_SCALAR};
+            continue;
+        }
+        for (int k = 0; k <= (int)best && count < capacity; k++) {
+            backends[count++] = (Backend){CASTER_PACKET, (PacketKernel)k};
+        }
+    }
+    return count;
+}
+
+// Renders the viewpoints of each golden file through the headless frame loop.
+// Size, caster and view options come from the file; the map from --map.
+static int RunGoldenChecks(const char** paths, int count, bool update, const char* mapPath, float viewDistance,
+                           int threads) {
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        GoldenSet golden;
+        if (!GoldenSetLoad(&golden, paths[i])) {
+            fprintf(stderr, "cannot read golden file %s\n", paths[i]);
+            failed++;
+            continue;
+        }
+        HeadlessOptions options = {
+            .mapPath = mapPath,
+            .width = golden.width,
+            .height = golden.height,
+            .showDebugMap = golden.showDebugMap,
+            .textured = golden.textured,
+            .caster = golden.caster,
+            .viewDistance = viewDistance > 0 ? viewDistance : MAX_RAY_DISTANCE,
+            .threads = threads,
+            .goldenPath = paths[i],
+            .goldenUpdate = update,
+        };
+        GoldenSetFree(&golden);
+        if (RunHeadless(&options) != 0) failed++;
+    }
+    printf("golden: %d of %d files %s\n", count - failed, count, update ? "written" : "match");
+    return failed > 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    int frames = 60, warmup = 10, repeat = 5, threads = 1;
+    bool pinThreads = false;
+    uint32_t seed = 1;
+    float viewDistance = 0; // 0 keeps each scenario's own
+    double threshold = 5.0;
+    int losQueries = 0;
+    const char* casterList = "dda,march,packet,hier,field,fixed";
+    const char* widthList = "320,800,1920";
+    const char* csvPath = NULL;
+    const char* jsonPath = NULL;
+    const char* baselinePath = NULL;
+    const char* mapPath = NULL;
+    const char* goldenPaths[MAX_GOLDEN];
+    int goldenCount = 0;
+    bool goldenUpdate = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            pinThreads = true;
+        } else if (strcmp(argv[i], "--widths") == 0 && i + 1 < argc) {
+            widthList = argv[++i];
+        } else if (strcmp(argv[i], "--casters") == 0 && i + 1 < argc) {
+            casterList = argv[++i];
+        } else if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+            mapPath = argv[++i];
+        } else if (strcmp(argv[i], "--view-distance") == 0 && i + 1 < argc) {
+            viewDistance = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--los") == 0 && i + 1 < argc) {
+            losQueries = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc && goldenCount < MAX_GOLDEN) {
+            goldenPaths[goldenCount++] = argv[++i];
+        } else if (strcmp(argv[i], "--golden-update") == 0) {
+            goldenUpdate = true;
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 1 || repeat < 1 || warmup < 0 || (goldenUpdate && goldenCount == 0)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    if (goldenCount > 0) return RunGoldenChecks(goldenPaths, goldenCount, goldenUpdate, mapPath, viewDistance, threads);
+
+    Backend backends[CASTER_COUNT + PACKET_KERNEL_COUNT];
+    int backendCount = ParseBackends(casterList, backends, CASTER_COUNT + PACKET_KERNEL_COUNT);
+    int widths[MAX_WIDTHS];
+    int widthCount = 0;
+    for (const char* p = widthList; *p && widthCount < MAX_WIDTHS; p = strchr(p, ',') ? strchr(p, ',') + 1 : "") {
+        widths[widthCount] = atoi(p);
+        if (widths[widthCount] > 0) widthCount++;
+    }
+    if (backendCount <= 0 || widthCount == 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    Scenario scenarios[MAX_SCENARIOS];
+    int scenarioCount = 0;
+    if (mapPath) {
+        scenarios[scenarioCount++] = (Scenario){mapPath, mapPath, 0, 0, 0.0f, 64.0f};
+    } else {
+        for (size_t s = 0; s < sizeof(defaultScenarios) / sizeof(defaultScenarios[0]); s++) {
+            scenarios[scenarioCount++] = defaultScenarios[s];
+        }
+    }
+    if (viewDistance > 0) {
+        for (int s = 0; s < scenarioCount; s++) scenarios[s].viewDistance = viewDistance;
+    }
+
+    // Human-readable progress moves to stderr when a machine format goes to stdout
+    bool machineStdout = (csvPath && strcmp(csvPath, "-") == 0) || (jsonPath && strcmp(jsonPath, "-") == 0);
+    FILE* log = machineStdout ? stderr : stdout;
+    int resultCapacity = scenarioCount * (widthCount * backendCount + 1);
+    BenchResult* results = malloc(sizeof(BenchResult) * resultCapacity);
+    ThreadPool* pool = ThreadPoolCreate(threads, pinThreads);
+    ThreadPoolPinCaller(pool);
+    if (!results) return 1;
+    int resultCount = 0;
+    int status = 0;
+
+    fprintf(log, "%-10s %5s %-7s %-7s %3s %10s %10s %9s %9s %7s %9s\n", "map", "width", "caster", "backend", "thr",
+            "ns/ray", "Mrays/s", "cast p50", "cast p99", "spread", "rss KiB");
+    for (int s = 0; s < scenarioCount && status == 0; s++) {
+        Level level = {.log = log};
+        if (!LoadScenario(&level, &scenarios[s], seed)) {
+            fprintf(stderr, "cannot load map %s\n", scenarios[s].name);
+            status = 1;
+            break;
+        }
+        for (int b = 0; b < backendCount && status == 0; b++) {
+            if (!PrepareCaster(&level, backends[b].caster)) {
+                status = 1;
+                break;
+            }
+            for (int w = 0; w < widthCount; w++) {
+                if (!RunCase(&level, &scenarios[s], widths[w], backends[b], frames, warmup, repeat, pool,
+                             &results[resultCount])) {
+                    status = 1;
+                    break;
+                }
+                PrintResult(log, &results[resultCount++]);
+            }
+        }
+        if (losQueries > 0 && status == 0) {
+            SetPacketKernel(PACKET_KERNEL_COUNT);
+            if (RunLosCase(&level, &scenarios[s], losQueries, frames, warmup, repeat, seed, pool,
+                           &results[resultCount])) {
+                PrintResult(log, &results[resultCount++]);
+            } else {
+                status = 1;
+            }
+        }
+        LevelFree(&level);
+    }
+    ThreadPoolDestroy(pool);
+
+    if (csvPath && !WriteResults(csvPath, results, resultCount, false)) status = 1;
+    if (jsonPath && !WriteResults(jsonPath, results, resultCount, true)) status = 1;
+    if (baselinePath && status == 0) {
+        static BaselineEntry baseline[MAX_BASELINE];
+        int baselineCount = LoadBaseline(baselinePath, baseline, MAX_BASELINE);
+        if (baselineCount < 0) {
+            status = 1;
+        } else {
+            int regressions = CompareBaseline(log, results, resultCount, baseline, baselineCount, threshold);
+            fprintf(log, "baseline: %d of %d cases slower by more than %.1f%%\n", regressions, resultCount,
+                    threshold);
+            if (regressions > 0) status = 2;
+        }
+    }
+    free(results);
+    return status;
+}
@@ -0,0 +1,118 @@
+#include "distfield.h"
+#include <stdlib.h>
+
+static inline uint8_t MinDistance(uint8_t a, uint8_t b) {
+    return a < b ? a : b;
+}
+
+// Two-pass chessboard transform of the window [x0, x1) x [y0, y1) into out
+// (row stride x1 - x0). Cells outside the map read as 0; cells outside the
+// window but inside the map read as DISTANCE_FIELD_MAX, which is still exact
+// for any cell at least DISTANCE_FIELD_MAX away from the window edge.
+static void TransformWindow(const Map* map, int x0, int y0, int x1, int y1, uint8_t* out) {
+    int stride = x1 - x0;
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            out[(size_t)(y - y0) * stride + x - x0] = MapIsSolid(map, x, y) ? 0 : DISTANCE_FIELD_MAX;
+        }
+    }
+
+#define NEIGHBOR(nx, ny)                                                                                               \
+    ((nx) < 0 || (ny) < 0 || (nx) >= map->width || (ny) >= map->height ? 0                                             \
+     : (nx) < x0 || (ny) < y0 || (nx) >= x1 || (ny) >= y1             ? DISTANCE_FIELD_MAX                             \
+                                                                       : out[(size_t)((ny) - y0) * stride + (nx) - x0])
+
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            uint8_t* d = &out[(size_t)(y - y0) * stride + x - x0];
+            if (*d == 0) continue;
+            uint8_t best = MinDistance(MinDistance(NEIGHBOR(x - 1, y), NEIGHBOR(x - 1, y - 1)),
+                                       MinDistance(NEIGHBOR(x, y - 1), NEIGHBOR(x + 1, y - 1)));
+            *d = MinDistance(*d, best + 1);
+        }
+    }
+    for (int y = y1 - 1; y >= y0; y--) {
+        for (int x = x1 - 1; x >= x0; x--) {
+            uint8_t* d = &out[(size_t)(y - y0) * stride + x - x0];
+            if (*d == 0) continue;
+            uint8_t best = MinDistance(MinDistance(NEIGHBOR(x + 1, y), NEIGHBOR(x + 1, y + 1)),
+                                       MinDistance(NEIGHBOR(x, y + 1), NEIGHBOR(x - 1, y + 1)));
+            *d = MinDistance(*d, best + 1);
+        }
+    }
+#undef NEIGHBOR
+}
+
+bool DistanceFieldBuild(DistanceField* field, const Map* map) {
+    *field = (DistanceField){.width = map->width, .height = map->height};
+    field->cells = malloc((size_t)map->width * map->height);
+    if (!field->cells) return false;
+    TransformWindow(map, 0, 0, map->width, map->height, field->cells);
+    return true;
+}
+
+void DistanceFieldFree(DistanceField* field) {
+    free(field->cells);
+    *field = (DistanceField){0};
+}
+
+// Reruns both passes in place over [x0, x1) x [y0, y1), reading the field
+// around it as is
+static void RetransformRegion(DistanceField* field, int x0, int y0, int x1, int y1) {
+#define NEIGHBOR(nx, ny)                                                                                               \
+    ((nx) < 0 || (ny) < 0 || (nx) >= field->width || (ny) >= field->height                                           \
+         ? 0                                                                                                           \
+         : field->cells[(size_t)(ny) * field->width + (nx)])
+
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            uint8_t* d = &field->cells[(size_t)y * field->width + x];
+            if (*d == 0) continue;
+            uint8_t best = MinDistance(MinDistance(NEIGHBOR(x - 1, y), NEIGHBOR(x - 1, y - 1)),
+                                       MinDistance(NEIGHBOR(x, y - 1), NEIGHBOR(x + 1, y - 1)));
+            *d = MinDistance(*d, best + 1);
+        }
+    }
+    for (int y = y1 - 1; y >= y0; y--) {
+        for (int x = x1 - 1; x >= x0; x--) {
+            uint8_t* d = &field->cells[(size_t)y * field->width + x];
+            if (*d == 0) continue;
+            uint8_t best = MinDistance(MinDistance(NEIGHBOR(x + 1, y), NEIGHBOR(x + 1, y + 1)),
+                                       MinDistance(NEIGHBOR(x, y + 1), NEIGHBOR(x - 1, y + 1)));
+            *d = MinDistance(*d, best + 1);
+        }
+    }
+#undef NEIGHBOR
+}
+
+// The cells an edit changes form one patch around it: stepping from such a
+// cell towards (x, y) always lands on another one. A new wall pulls the cells
+// of the patch down to their distance from it. A removed wall frees the cells
+// it was nearest to, which are then refilled from the cells around them.
+void DistanceFieldUpdateCell(DistanceField* field, const Map* map, int x, int y) {
+    int stack[(2 * DISTANCE_FIELD_MAX - 1) * (2 * DISTANCE_FIELD_MAX - 1)];
+    int count = 0;
+    bool solid = MapIsSolid(map, x, y);
+    int x0 = x, y0 = y, x1 = x, y1 = y;
+
+    field->cells[(size_t)y * field->width + x] = solid ? 0 : DISTANCE_FIELD_MAX;
+    stack[count++] = y * field->width + x;
+    while (count > 0) {
+        int cellX = stack[--count] % field->width, cellY = stack[count] / field->width;
+        x0 = cellX < x0 ? cellX : x0;
+        y0 = cellY < y0 ? cellY : y0;
+        x1 = cellX > x1 ? cellX : x1;
+        y1 = cellY > y1 ? cellY : y1;
+        for (int n = 0; n < 9; n++) {
+            int nx = cellX + n % 3 - 1, ny = cellY + n / 3 - 1;
+            if (nx < 0 || ny < 0 || nx >= field->width || ny >= field->height) continue;
+            uint8_t* d = &field->cells[(size_t)ny * field->width + nx];
+            int distance = abs(nx - x) > abs(ny - y) ? abs(nx - x) : abs(ny - y);
+            bool changes = solid ? distance < *d : distance == *d && distance < DISTANCE_FIELD_MAX;
+            if (!changes) continue;
+            *d = solid ? (uint8_t)distance : DISTANCE_FIELD_MAX;
+            stack[count++] = ny * field->width + nx;
+        }
+    }
+    if (!solid) RetransformRegion(field, x0, y0, x1 + 1, y1 + 1);
+}
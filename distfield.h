@@ -0,0 +1,26 @@
+#ifndef DISTFIELD_H
+#define DISTFIELD_H
+
+#include "world.h"
+
+// Chessboard distance from each cell to the nearest solid cell, capped at
+// DISTANCE_FIELD_MAX. Solid cells hold 0 and everything outside the map
+// counts as solid, so a cell holding d has only empty cells within d - 1.
+#define DISTANCE_FIELD_MAX 32
+
+typedef struct {
+    int width;
+    int height;
+    uint8_t* cells;
+} DistanceField;
+
+bool DistanceFieldBuild(DistanceField* field, const Map* map);
+void DistanceFieldFree(DistanceField* field);
+// Brings the field back in step after cell (x, y) of map changed
+void DistanceFieldUpdateCell(DistanceField* field, const Map* map, int x, int y);
+
+static inline int DistanceFieldGet(const DistanceField* field, int x, int y) {
+    return field->cells[(size_t)y * field->width + x];
+}
+
+#endif
@@ -0,0 +1,77 @@
+#include "dynres.h"
+#include "render.h"
+#include <math.h>
+
+// Cost is taken as proportional to the pixel count; the margins keep the
+// controller from hunting around the budget
+#define DYNRES_HEADROOM 0.9 // Aim this far under the budget when cutting
+#define DYNRES_RAISE_BELOW 0.7 // Only grow once frames cost less than this share of the budget
+#define DYNRES_MAX_CUT 0.5 // Per decision, as area factors
+#define DYNRES_MAX_GROWTH 1.25
+
+bool DynamicResolutionInit(DynamicResolution* resolution, int width, int height, double budgetMs,
+                           bool scaleVertical) {
+    *resolution = (DynamicResolution){.budgetMs = budgetMs, .scaleVertical = scaleVertical, .scaleX = 1.0f,
+                                      .scaleY = 1.0f};
+    return FramebufferInit(&resolution->target, width, height);
+}
+
+void DynamicResolutionFree(DynamicResolution* resolution) {
+    FramebufferFree(&resolution->target);
+    *resolution = (DynamicResolution){0};
+}
+
+Framebuffer* DynamicResolutionBegin(DynamicResolution* resolution, Framebuffer* full) {
+    int width = (int)lroundf(full->width * resolution->scaleX / DYNRES_WIDTH_STEP) * DYNRES_WIDTH_STEP;
+    int height = (int)lroundf(full->height * resolution->scaleY);
+    width = width < 2 * DYNRES_WIDTH_STEP ? 2 * DYNRES_WIDTH_STEP : width;
+    height = height < 2 ? 2 : height;
+    resolution->active = width < full->width || height < full->height;
+    if (!resolution->active) return full;
+
+    // The target keeps its full-size allocation and is simply addressed with a narrower stride
+    resolution->target.width = width < full->width ? width : full->width;
+    resolution->target.height = height < full->height ? height : full->height;
+    return &resolution->target;
+}
+
+void DynamicResolutionEnd(DynamicResolution* resolution, Framebuffer* full, bool showDebugMap) {
+    if (!resolution->active) return;
+    const Framebuffer* target = &resolution->target;
+    int srcX = GetViewColumnX(target->width, showDebugMap, 0);
+    int dstX = GetViewColumnX(full->width, showDebugMap, 0);
+    // Nothing else drew into full this frame, so the map half starts from black too
+    if (dstX > 0) FramebufferFillRect(full, 0, 0, dstX, full->height, PIXEL_BLACK);
+    FramebufferBlitScaled(full, dstX, 0, full->width - dstX, full->height, target, srcX, 0, target->width - srcX,
+                          target->height);
+}
+
+void DynamicResolutionUpdate(DynamicResolution* resolution, double frameMs) {
+    resolution->samples[resolution->sampleCount++] = frameMs;
+    if (resolution->sampleCount < DYNRES_WINDOW) return;
+    double average = 0;
+    for (int i = 0; i < DYNRES_WINDOW; i++) average += resolution->samples[i];
+    average /= DYNRES_WINDOW;
+    resolution->sampleCount = 0;
+
+    double area = (double)resolution->scaleX * resolution->scaleY;
+    double target = area;
+    if (average > resolution->budgetMs) {
+        double factor = resolution->budgetMs * DYNRES_HEADROOM / average;
+        target = area * (factor < DYNRES_MAX_CUT ? DYNRES_MAX_CUT : factor);
+    } else if (average < resolution->budgetMs * DYNRES_RAISE_BELOW) {
+        double factor = average > 0 ? resolution->budgetMs * DYNRES_HEADROOM / average : DYNRES_MAX_GROWTH;
+        target = area * (factor > DYNRES_MAX_GROWTH ? DYNRES_MAX_GROWTH : factor);
+    }
+    if (target > 1.0) target = 1.0;
+
+    float scaleX = resolution->scaleVertical ? (float)sqrt(target) : (float)target;
+    float scaleY = resolution->scaleVertical ? scaleX : 1.0f;
+    scaleX = scaleX < DYNRES_MIN_SCALE ? DYNRES_MIN_SCALE : scaleX;
+    scaleY = scaleY < DYNRES_MIN_SCALE ? DYNRES_MIN_SCALE : scaleY;
+    if (fabsf(scaleX - resolution->scaleX) > 0.01f || fabsf(scaleY - resolution->scaleY) > 0.01f) {
+        resolution->scaleX = scaleX;
+        resolution->scaleY = scaleY;
+        resolution->changes++;
+    }
+}
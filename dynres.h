@@ -0,0 +1,36 @@
+#ifndef DYNRES_H
+#define DYNRES_H
+
+#include "framebuffer.h"
+
+// Dynamic resolution: the 3D view is drawn into a smaller target and
+// stretched over the window when recent frames run over a time budget. The
+// controller watches the cost of the scaled work only (cast, walls, floor,
+// sprites), never presentation or vsync waits.
+#define DYNRES_WINDOW 8 // Frames averaged per decision, counted from the last change
+#define DYNRES_MIN_SCALE 0.25f
+#define DYNRES_WIDTH_STEP 8 // Target widths are multiples of this
+
+typedef struct {
+    double budgetMs;
+    bool scaleVertical; // Trade rows as well as columns
+    float scaleX; // Current target size over the full view, for instrumentation
+    float scaleY;
+    double samples[DYNRES_WINDOW];
+    int sampleCount;
+    int changes;
+    Framebuffer target; // Allocated at full size, used at the scaled size
+    bool active; // The last Begin handed out the scaled target
+} DynamicResolution;
+
+bool DynamicResolutionInit(DynamicResolution* resolution, int width, int height, double budgetMs,
+                           bool scaleVertical);
+void DynamicResolutionFree(DynamicResolution* resolution);
+// Returns the framebuffer to draw the view into: full itself at scale 1
+Framebuffer* DynamicResolutionBegin(DynamicResolution* resolution, Framebuffer* full);
+// Stretches the view area of the scaled target over the view area of full
+void DynamicResolutionEnd(DynamicResolution* resolution, Framebuffer* full, bool showDebugMap);
+// Feeds the measured cost of one frame's scaled work
+void DynamicResolutionUpdate(DynamicResolution* resolution, double frameMs);
+
+#endif
@@ -0,0 +1,62 @@
+#include "fixed.h"
+#include <math.h>
+
+// Angles are radians and values have 30 fraction bits (Q30) in here, the
+// same as FixedDir. Products are divided rather than shifted so negative
+// values round the same way as positive ones on every target.
+#define Q30_ONE (1LL << 30)
+#define HALF_PI_Q30 1686629713LL // round(pi / 2 * 2^30)
+#define Q30_MUL(a, b) ((a) * (b) / Q30_ONE)
+#define DEGREE_THOUSANDTHS 360000LL // Per full turn
+
+// Taylor series to x^15 for |x| <= pi/2; the truncation error is below 2^-30
+static int64_t SinQ30(int64_t x) {
+    int64_t x2 = Q30_MUL(x, x);
+    int64_t term = x;
+    int64_t sum = x;
+    for (int k = 1; k <= 7; k++) {
+        term = -Q30_MUL(term, x2) / (2 * k * (2 * k + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+FixedAngle FixedAngleFromDegrees(float degrees) {
+    long long thousandths = llroundf(degrees * 1000.0f) % DEGREE_THOUSANDTHS;
+    if (thousandths < 0) thousandths += DEGREE_THOUSANDTHS;
+    return (FixedAngle)(thousandths * (1LL << 32) / DEGREE_THOUSANDTHS);
+}
+
+void FixedSinCos(FixedAngle angle, FixedDir* sine, FixedDir* cosine) {
+    // Quadrant from the top two bits, the rest mapped onto [0, pi/2)
+    int64_t x = (int64_t)(angle & (Q30_ONE - 1)) * HALF_PI_Q30 / Q30_ONE;
+    FixedDir s = (FixedDir)SinQ30(x);
+    FixedDir c = (FixedDir)SinQ30(HALF_PI_Q30 - x);
+    switch (angle >> 30) {
+    case 0:
+        *sine = s;
+        *cosine = c;
+        break;
+    case 1:
+        *sine = c;
+        *cosine = -s;
+        break;
+    case 2:
+        *sine = -s;
+        *cosine = -c;
+        break;
+    default:
+        *sine = -c;
+        *cosine = s;
+        break;
+    }
+}
+
+FixedDir FixedColumnTan(int index, int count, float fovDegrees) {
+    int64_t fov = FixedAngleFromDegrees(fovDegrees);
+    int64_t angle = (int64_t)(2 * index - count) * fov / (2 * count);
+    int64_t x = angle * HALF_PI_Q30 / Q30_ONE;
+    int64_t s = SinQ30(x);
+    int64_t c = SinQ30(HALF_PI_Q30 - (x < 0 ? -x : x));
+    return (FixedDir)(s * Q30_ONE / c);
+}
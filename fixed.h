@@ -0,0 +1,38 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <stdint.h>
+
+// Fixed-point numbers for the deterministic caster. Everything here is
+// integer arithmetic, so results do not depend on the compiler, libm or
+// floating-point flags. Positions and distances are 16.16 by default, which
+// holds map coordinates up to 32767; more fraction bits trade map size for
+// precision. Sines, tangents and ray directions stay below 2 in magnitude and
+// keep 30 fraction bits, so near-axis rays still cross cells accurately.
+#ifndef FIXED_FRACTION_BITS
+#define FIXED_FRACTION_BITS 16
+#endif
+#define FIXED_ONE ((Fixed)1 << FIXED_FRACTION_BITS)
+#define FIXED_DIR_BITS 30
+#define FIXED_DIR_ONE ((FixedDir)1 << FIXED_DIR_BITS)
+
+typedef int32_t Fixed;
+typedef int32_t FixedDir; // FIXED_DIR_BITS fraction bits
+typedef uint32_t FixedAngle; // Binary angle: 2^32 per full turn, so it wraps for free
+
+// Exact for the values positions and distances take (multiples of 1/2^16 well within range)
+static inline Fixed FixedFromFloat(float value) {
+    return (Fixed)(value * (float)FIXED_ONE);
+}
+
+static inline float FixedToFloat(int64_t value) {
+    return (float)value / (float)FIXED_ONE;
+}
+
+// Degrees are rounded to thousandths first, so 0/90/180/270 land exactly on the quadrants
+FixedAngle FixedAngleFromDegrees(float degrees);
+void FixedSinCos(FixedAngle angle, FixedDir* sine, FixedDir* cosine);
+// Tangent of the signed angle (2 * index - count) * fov / (2 * count), |angle| < 63 degrees
+FixedDir FixedColumnTan(int index, int count, float fovDegrees);
+
+#endif
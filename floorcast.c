@@ -0,0 +1,186 @@
+#include "floorcast.h"
+#include "profile.h"
+#include "raypacket.h"
+#include "render.h"
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_SPANS 1
+#include <immintrin.h>
+#endif
+
+// Rays are processed in blocks so doubled-up columns can go through a small
+// stack buffer
+#define FLOOR_BLOCK 512
+
+// One floor row and its mirrored ceiling row: the floor point under column i
+// is (baseX + stepX * offset[i], baseY + stepY * offset[i])
+typedef struct {
+    float baseX;
+    float baseY;
+    float stepX;
+    float stepY;
+    int sizeShift; // log2 of the mip size
+    const Pixel* floorTexels;
+    const Pixel* ceilingTexels;
+} FloorRow;
+
+typedef struct {
+    Framebuffer* fb;
+    const RayTable* table;
+    const TextureAtlas* atlas;
+    float originX;
+    float originY;
+    float cosA;
+    float sinA;
+    float angleStep; // Radians between neighbouring columns
+    int columnWidth;
+    int viewX;
+    bool avx2;
+} FloorJob;
+
+static inline Pixel DarkenPixel(Pixel p) {
+    return ((p >> 1) & 0x007F7F7Fu) | (p & 0xFF000000u);
+}
+
+// Coordinates are pre-scaled to texels the same way in both spans, so the
+// scalar and vector paths produce identical pixels
+static void FloorSpanScalar(const FloorRow* row, const float* offset, int count, Pixel* floorDst, Pixel* ceilingDst) {
+    float scale = (float)(1 << row->sizeShift);
+    float baseX = row->baseX * scale;
+    float baseY = row->baseY * scale;
+    float stepX = row->stepX * scale;
+    float stepY = row->stepY * scale;
+    int mask = (1 << row->sizeShift) - 1;
+    for (int i = 0; i < count; i++) {
+        int u = (int)(baseX + stepX * offset[i]) & mask;
+        int v = (int)(baseY + stepY * offset[i]) & mask;
+        int texel = (u << row->sizeShift) | v;
+        floorDst[i] = row->floorTexels[texel];
+        if (ceilingDst) ceilingDst[i] = DarkenPixel(row->ceilingTexels[texel]);
+    }
+}
+
+#ifdef HAVE_X86_SPANS
+__attribute__((target("avx2"))) static void FloorSpanAVX2(const FloorRow* row, const float* offset, int count,
+                                                          Pixel* floorDst, Pixel* ceilingDst) {
+    __m256 baseX = _mm256_set1_ps(row->baseX * (float)(1 << row->sizeShift));
+    __m256 baseY = _mm256_set1_ps(row->baseY * (float)(1 << row->sizeShift));
+    __m256 stepX = _mm256_set1_ps(row->stepX * (float)(1 << row->sizeShift));
+    __m256 stepY = _mm256_set1_ps(row->stepY * (float)(1 << row->sizeShift));
+    __m256i mask = _mm256_set1_epi32((1 << row->sizeShift) - 1);
+    __m128i shift = _mm_cvtsi32_si128(row->sizeShift);
+    __m256i darkMask = _mm256_set1_epi32(0x007F7F7F);
+    __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 t = _mm256_loadu_ps(offset + i);
+        __m256i u = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_add_ps(baseX, _mm256_mul_ps(stepX, t))), mask);
+        __m256i v = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_add_ps(baseY, _mm256_mul_ps(stepY, t))), mask);
+        __m256i texel = _mm256_or_si256(_mm256_sll_epi32(u, shift), v);
+        __m256i floorPixels = _mm256_i32gather_epi32((const int*)row->floorTexels, texel, 4);
+        _mm256_storeu_si256((__m256i*)(floorDst + i), floorPixels);
+        if (ceilingDst) {
+            __m256i ceilingPixels = _mm256_i32gather_epi32((const int*)row->ceilingTexels, texel, 4);
+            ceilingPixels = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(ceilingPixels, 1), darkMask), alpha);
+            _mm256_storeu_si256((__m256i*)(ceilingDst + i), ceilingPixels);
+        }
+    }
+    FloorSpanScalar(row, offset + i, count - i, floorDst + i, ceilingDst ? ceilingDst + i : NULL);
+}
+#endif
+
+// Mip level for a row: texels covered by one pixel across or along the row
+static int SelectFloorLevel(float distance, float screenOffset, float angleStep) {
+    float across = distance * angleStep;
+    float along = distance / screenOffset;
+    float texels = (across > along ? across : along) * TEXTURE_SIZE;
+    int level = 0;
+    while (level + 1 < TEXTURE_LEVELS && texels >= 2.0f) {
+        texels *= 0.5f;
+        level++;
+    }
+    return level;
+}
+
+static void RenderFloorRows(void* context, int begin, int end) {
+    uint64_t zone = ProfileBegin();
+    const FloorJob* job = context;
+    Framebuffer* fb = job->fb;
+    // Doubled columns can run past the right edge; those rays are not drawn
+    int visibleRays = (fb->width - job->viewX + job->columnWidth - 1) / job->columnWidth;
+    int numRays = job->table->numRays < visibleRays ? job->table->numRays : visibleRays;
+    int horizon = fb->height / 2;
+
+    for (int r = begin; r < end; r++) {
+        int y = horizon + r;
+        int ceilingY = fb->height - 1 - y;
+
+        // Matches the wall projection, where a wall at distance d reaches height / d below the horizon
+        float screenOffset = r + 0.5f;
+        float distance = fb->height / screenOffset;
+        int level = SelectFloorLevel(distance, screenOffset, job->angleStep);
+        FloorRow row = {
+            .baseX = job->originX + distance * job->cosA,
+            .baseY = job->originY + distance * job->sinA,
+            .stepX = -distance * job->sinA,
+            .stepY = distance * job->cosA,
+            .sizeShift = TEXTURE_SIZE_SHIFT - level,
+            .floorTexels = TextureAtlasColumn(job->atlas, FLOOR_MATERIAL, level, 0),
+            .ceilingTexels = TextureAtlasColumn(job->atlas, CEILING_MATERIAL, level, 0),
+        };
+
+        Pixel* floorDst = fb->pixels + (size_t)y * fb->width + job->viewX;
+        Pixel* ceilingDst = ceilingY != y ? fb->pixels + (size_t)ceilingY * fb->width + job->viewX : NULL;
+        for (int i = 0; i < numRays; i += FLOOR_BLOCK) {
+            int count = numRays - i < FLOOR_BLOCK ? numRays - i : FLOOR_BLOCK;
+            Pixel floorBlock[FLOOR_BLOCK];
+            Pixel ceilingBlock[FLOOR_BLOCK];
+            bool direct = job->columnWidth == 1;
+            Pixel* floorOut = direct ? floorDst + i : floorBlock;
+            Pixel* ceilingOut = direct ? (ceilingDst ? ceilingDst + i : NULL) : (ceilingDst ? ceilingBlock : NULL);
+
+#ifdef HAVE_X86_SPANS
+            if (job->avx2) {
+                FloorSpanAVX2(&row, job->table->offset + i, count, floorOut, ceilingOut);
+            } else
+#endif
+            {
+                FloorSpanScalar(&row, job->table->offset + i, count, floorOut, ceilingOut);
+            }
+
+            if (!direct) {
+                int viewWidth = fb->width - job->viewX;
+                for (int k = 0; k < count; k++) {
+                    int x = (i + k) * job->columnWidth;
+                    int x1 = x + job->columnWidth > viewWidth ? viewWidth : x + job->columnWidth;
+                    for (; x < x1; x++) {
+                        floorDst[x] = floorBlock[k];
+                        if (ceilingDst) ceilingDst[x] = ceilingBlock[k];
+                    }
+                }
+            }
+        }
+    }
+    ProfileEnd(PROFILE_FLOOR_ROWS, zone);
+}
+
+void RenderFloorCeiling(Framebuffer* fb, const RayTable* table, const Player* player, bool showDebugMap,
+                        const TextureAtlas* atlas, ThreadPool* pool) {
+    FloorJob job = {
+        .fb = fb,
+        .table = table,
+        .atlas = atlas,
+        .originX = player->pos.x + PLAYER_OFFSET,
+        .originY = player->pos.y + PLAYER_OFFSET,
+        .cosA = cosf(player->angle * DEG2RAD),
+        .sinA = sinf(player->angle * DEG2RAD),
+        .angleStep = table->fov / table->numRays * DEG2RAD,
+        .columnWidth = GetViewColumnWidth(showDebugMap),
+        .viewX = GetViewColumnX(fb->width, showDebugMap, 0),
+        // Follows the packet caster's kernel choice, so --simd also narrows this
+        .avx2 = GetPacketKernel() >= PACKET_AVX2,
+    };
+    ThreadPoolRun(pool, RenderFloorRows, &job, fb->height - fb->height / 2);
+}
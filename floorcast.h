@@ -0,0 +1,19 @@
+#ifndef FLOORCAST_H
+#define FLOORCAST_H
+
+#include "framebuffer.h"
+#include "raycast.h"
+#include "texture.h"
+
+// Atlas materials used for the floor and the ceiling
+#define FLOOR_MATERIAL 2
+#define CEILING_MATERIAL 9
+
+// Fills the whole view area with a textured floor and ceiling, one scanline
+// pair at a time: the world-space start and step along a row are computed
+// once, then pixels are produced 8 at a time (AVX2 gathers) straight into the
+// framebuffer. Walls are drawn on top afterwards.
+void RenderFloorCeiling(Framebuffer* fb, const RayTable* table, const Player* player, bool showDebugMap,
+                        const TextureAtlas* atlas, ThreadPool* pool);
+
+#endif
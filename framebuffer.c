@@ -0,0 +1,149 @@
+#include "framebuffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool FramebufferInit(Framebuffer* fb, int width, int height) {
+    fb->width = width;
+    fb->height = height;
+    fb->pixels = malloc((size_t)width * height * sizeof(Pixel));
+    return fb->pixels != NULL;
+}
+
+void FramebufferFree(Framebuffer* fb) {
+    free(fb->pixels);
+    fb->pixels = NULL;
+    fb->width = fb->height = 0;
+}
+
+void FramebufferClear(Framebuffer* fb, Pixel color) {
+    size_t count = (size_t)fb->width * fb->height;
+    for (size_t i = 0; i < count; i++) fb->pixels[i] = color;
+}
+
+void FramebufferFillRect(Framebuffer* fb, int x, int y, int width, int height, Pixel color) {
+    int x0 = x < 0 ? 0 : x;
+    int y0 = y < 0 ? 0 : y;
+    int x1 = x + width > fb->width ? fb->width : x + width;
+    int y1 = y + height > fb->height ? fb->height : y + height;
+
+    for (int row = y0; row < y1; row++) {
+        Pixel* dst = fb->pixels + (size_t)row * fb->width;
+        for (int col = x0; col < x1; col++) dst[col] = color;
+    }
+}
+
+void FramebufferFillCircle(Framebuffer* fb, int centerX, int centerY, int radius, Pixel color) {
+    for (int dy = -radius; dy <= radius; dy++) {
+        int y = centerY + dy;
+        if (y < 0 || y >= fb->height) continue;
+        for (int dx = -radius; dx <= radius; dx++) {
+            int x = centerX + dx;
+            if (x < 0 || x >= fb->width || dx * dx + dy * dy > radius * radius) continue;
+            fb->pixels[(size_t)y * fb->width + x] = color;
+        }
+    }
+}
+
+void FramebufferDrawLine(Framebuffer* fb, int x0, int y0, int x1, int y1, Pixel color) {
+    // Bresenham
+    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+
+    for (;;) {
+        if (x0 >= 0 && x0 < fb->width && y0 >= 0 && y0 < fb->height) fb->pixels[(size_t)y0 * fb->width + x0] = color;
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+void FramebufferBlitScaled(Framebuffer* dst, int dstX, int dstY, int dstWidth, int dstHeight, const Framebuffer* src,
+                           int srcX, int srcY, int srcWidth, int srcHeight) {
+    if (dstWidth <= 0 || dstHeight <= 0 || srcWidth <= 0 || srcHeight <= 0) return;
+    // Source column of every destination column, sampled at pixel centres
+    int columns[dstWidth];
+    for (int x = 0; x < dstWidth; x++) columns[x] = srcX + (int)(((int64_t)x * 2 + 1) * srcWidth / (dstWidth * 2));
+
+    int y0 = dstY < 0 ? -dstY : 0;
+    int y1 = dstY + dstHeight > dst->height ? dst->height - dstY : dstHeight;
+    int x0 = dstX < 0 ? -dstX : 0;
+    int x1 = dstX + dstWidth > dst->width ? dst->width - dstX : dstWidth;
+    int previousRow = -1;
+    for (int y = y0; y < y1; y++) {
+        int srcRow = srcY + (int)(((int64_t)y * 2 + 1) * srcHeight / (dstHeight * 2));
+        Pixel* out = dst->pixels + (size_t)(dstY + y) * dst->width + dstX;
+        if (srcRow == previousRow) {
+            // Repeated source rows copy the row just written
+            memcpy(out + x0, out - dst->width + x0, sizeof(Pixel) * (x1 - x0));
+            continue;
+        }
+        const Pixel* in = src->pixels + (size_t)srcRow * src->width;
+        for (int x = x0; x < x1; x++) out[x] = in[columns[x]];
+        previousRow = srcRow;
+    }
+}
+
+bool FramebufferWritePPM(const Framebuffer* fb, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+
+    unsigned char* row = malloc((size_t)fb->width * 3);
+    if (!row) {
+        fclose(file);
+        return false;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", fb->width, fb->height);
+    for (int y = 0; y < fb->height; y++) {
+        const Pixel* src = fb->pixels + (size_t)y * fb->width;
+        for (int x = 0; x < fb->width; x++) {
+            row[x * 3 + 0] = src[x] & 0xFF;
+            row[x * 3 + 1] = (src[x] >> 8) & 0xFF;
+            row[x * 3 + 2] = (src[x] >> 16) & 0xFF;
+        }
+        fwrite(row, 3, fb->width, file);
+    }
+    free(row);
+    return fclose(file) == 0;
+}
+
+bool FramebufferReadPPM(Framebuffer* fb, const char* path) {
+    *fb = (Framebuffer){0};
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    int width, height, maxValue;
+    unsigned char* row = NULL;
+    // One whitespace byte separates the header from the pixels
+    bool ok = fscanf(file, "P6 %d %d %d", &width, &height, &maxValue) == 3 && maxValue == 255 && width > 0 &&
+              height > 0 && fgetc(file) != EOF;
+    if (ok) row = malloc((size_t)width * 3);
+    ok = row && FramebufferInit(fb, width, height);
+    for (int y = 0; ok && y < height; y++) {
+        ok = fread(row, 3, width, file) == (size_t)width;
+        Pixel* dst = fb->pixels + (size_t)y * width;
+        for (int x = 0; ok && x < width; x++) dst[x] = PIXEL_RGBA(row[x * 3 + 0], row[x * 3 + 1], row[x * 3 + 2], 255);
+    }
+    free(row);
+    fclose(file);
+    if (!ok) FramebufferFree(fb);
+    return ok;
+}
+
+uint64_t FramebufferHash(const Framebuffer* fb) {
+    uint64_t hash = 14695981039346656037u;
+    hash = (hash ^ (uint64_t)fb->width) * 1099511628211u;
+    hash = (hash ^ (uint64_t)fb->height) * 1099511628211u;
+    size_t count = (size_t)fb->width * fb->height;
+    for (size_t i = 0; i < count; i++) hash = (hash ^ fb->pixels[i]) * 1099511628211u;
+    return hash;
+}
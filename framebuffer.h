@@ -0,0 +1,41 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Pixels are 32-bit RGBA laid out r, g, b, a in memory (same as raylib's
+// PIXELFORMAT_UNCOMPRESSED_R8G8B8A8), so the buffer can be uploaded as-is.
+typedef uint32_t Pixel;
+
+#define PIXEL_RGBA(r, g, b, a) ((Pixel)(r) | ((Pixel)(g) << 8) | ((Pixel)(b) << 16) | ((Pixel)(a) << 24))
+
+// raylib palette equivalents
+#define PIXEL_BLACK PIXEL_RGBA(0, 0, 0, 255)
+#define PIXEL_BLUE PIXEL_RGBA(0, 121, 241, 255)
+#define PIXEL_DARKGRAY PIXEL_RGBA(80, 80, 80, 255)
+#define PIXEL_GRAY PIXEL_RGBA(130, 130, 130, 255)
+#define PIXEL_RED PIXEL_RGBA(230, 41, 55, 255)
+
+typedef struct {
+    int width;
+    int height;
+    Pixel* pixels;
+} Framebuffer;
+
+bool FramebufferInit(Framebuffer* fb, int width, int height);
+void FramebufferFree(Framebuffer* fb);
+void FramebufferClear(Framebuffer* fb, Pixel color);
+void FramebufferFillRect(Framebuffer* fb, int x, int y, int width, int height, Pixel color);
+void FramebufferFillCircle(Framebuffer* fb, int centerX, int centerY, int radius, Pixel color);
+void FramebufferDrawLine(Framebuffer* fb, int x0, int y0, int x1, int y1, Pixel color);
+// Nearest-neighbour copy of a src rectangle stretched over a dst rectangle
+void FramebufferBlitScaled(Framebuffer* dst, int dstX, int dstY, int dstWidth, int dstHeight, const Framebuffer* src,
+                           int srcX, int srcY, int srcWidth, int srcHeight);
+bool FramebufferWritePPM(const Framebuffer* fb, const char* path);
+// Reads a binary PPM as written above into a new framebuffer, alpha 255
+bool FramebufferReadPPM(Framebuffer* fb, const char* path);
+// FNV-1a over the pixels, for comparing frames without keeping them
+uint64_t FramebufferHash(const Framebuffer* fb);
+
+#endif
@@ -0,0 +1,107 @@
+#include "golden.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Off-axis headings catch rays that the grid headings never cast
+static const float viewAngles[] = {0.0f, 90.0f, 180.0f, 270.0f, 30.0f, 135.0f, 222.5f, 315.0f, 12.25f, 101.0f};
+
+bool GoldenSetPickViews(GoldenSet* set, const Map* map, int count) {
+    set->views = calloc(count > 4 ? count : 4, sizeof(GoldenView));
+    if (!set->views) return false;
+    set->count = 0;
+    for (int i = 0; i < 4; i++) {
+        set->views[set->count++] = (GoldenView){map->spawnX, map->spawnY, viewAngles[i], 0};
+    }
+
+    long open = 0;
+    for (int y = 0; y < map->height; y++) {
+        for (int x = 0; x < map->width; x++) open += !MapIsSolid(map, x, y);
+    }
+    // The middle of each of count - 4 equal runs of open cells, in row order
+    int spread = count - 4;
+    long seen = 0;
+    for (int y = 0; spread > 0 && y < map->height && set->count < count; y++) {
+        for (int x = 0; x < map->width && set->count < count; x++) {
+            if (MapIsSolid(map, x, y)) continue;
+            int index = set->count - 4;
+            if (seen++ == (long)((index * 2 + 1) * (int64_t)open / (spread * 2))) {
+                float angle = viewAngles[(set->count + 4) % (sizeof(viewAngles) / sizeof(viewAngles[0]))];
+                set->views[set->count++] = (GoldenView){x, y, angle, 0};
+            }
+        }
+    }
+    return true;
+}
+
+bool GoldenSetLoad(GoldenSet* set, const char* path) {
+    *set = (GoldenSet){0};
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+
+    int version = 0, textured = 0, showDebugMap = 0;
+    char casterName[16];
+    bool ok = fscanf(file, "golden %d %dx%d caster=%15s textured=%d map=%d maphash=%" SCNx64, &version, &set->width,
+                     &set->height, casterName, &textured, &showDebugMap, &set->mapHash) == 7 &&
+              version == GOLDEN_VERSION && ParseCasterName(casterName, &set->caster);
+    set->textured = textured != 0;
+    set->showDebugMap = showDebugMap != 0;
+
+    int capacity = 0;
+    GoldenView view;
+    while (ok && fscanf(file, "%d %d %f %" SCNx64, &view.x, &view.y, &view.angle, &view.hash) == 4) {
+        if (set->count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            GoldenView* views = realloc(set->views, sizeof(GoldenView) * capacity);
+            if (!views) {
+                ok = false;
+                break;
+            }
+            set->views = views;
+        }
+        set->views[set->count++] = view;
+    }
+    ok = ok && feof(file) && set->count > 0;
+    fclose(file);
+    if (!ok) GoldenSetFree(set);
+    return ok;
+}
+
+bool GoldenSetSave(const GoldenSet* set, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+    fprintf(file, "golden %d %dx%d caster=%s textured=%d map=%d maphash=%016" PRIx64 "\n", GOLDEN_VERSION, set->width,
+            set->height, GetCasterName(set->caster), set->textured, set->showDebugMap, set->mapHash);
+    for (int i = 0; i < set->count; i++) {
+        const GoldenView* view = &set->views[i];
+        fprintf(file, "%d %d %.3f %016" PRIx64 "\n", view->x, view->y, view->angle, view->hash);
+    }
+    return fclose(file) == 0;
+}
+
+void GoldenSetFree(GoldenSet* set) {
+    free(set->views);
+    *set = (GoldenSet){0};
+}
+
+long GoldenWriteDiff(const Framebuffer* actual, const Framebuffer* expected, const char* path) {
+    if (actual->width != expected->width || actual->height != expected->height) return -1;
+    Framebuffer diff;
+    if (!FramebufferInit(&diff, actual->width, actual->height)) return -1;
+
+    long differing = 0;
+    size_t count = (size_t)actual->width * actual->height;
+    for (size_t i = 0; i < count; i++) {
+        Pixel a = actual->pixels[i], e = expected->pixels[i];
+        if ((a & 0xFFFFFF) != (e & 0xFFFFFF)) {
+            diff.pixels[i] = PIXEL_RGBA(255, 0, 0, 255);
+            differing++;
+        } else {
+            unsigned luma = ((e & 0xFF) + ((e >> 8) & 0xFF) * 2 + ((e >> 16) & 0xFF)) / 16;
+            diff.pixels[i] = PIXEL_RGBA(luma, luma, luma, 255);
+        }
+    }
+    bool ok = FramebufferWritePPM(&diff, path);
+    FramebufferFree(&diff);
+    return ok ? differing : -1;
+}
@@ -0,0 +1,55 @@
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+#include "framebuffer.h"
+#include "raycast.h"
+
+// Golden frames: fixed viewpoints with the hash each one rendered to when the
+// file was written. The file is text so it can be checked in and diffed:
+//
+//   golden 1 800x600 caster=fixed textured=0 map=1 maphash=<hex>
+//   <cell x> <cell y> <angle> <frame hash hex>
+//
+// Reference images are written next to it as <file>.NNN.ppm; when they are
+// kept, a mismatch also gets a per-pixel <file>.NNN.diff.ppm.
+//
+// golden-<caster>.txt cover the built-in map at the default size, one file
+// per caster, since casters differ from each other by a few pixels:
+//
+//   main12 --headless --caster dda --golden golden-dda.txt
+//   bench --golden golden-dda.txt --golden golden-packet.txt ...   (no raylib)
+//
+// The float casters matched across SIMD kernels and from -O0 to -O3
+// -ffast-math with gcc on x86-64; another compiler or target may need its own
+// files. The fixed caster's frames are integer-only and match everywhere.
+#define GOLDEN_VERSION 1
+#define GOLDEN_DEFAULT_VIEWS 16
+
+typedef struct {
+    int x;
+    int y;
+    float angle;
+    uint64_t hash;
+} GoldenView;
+
+typedef struct {
+    int width;
+    int height;
+    CasterKind caster; // The caster that wrote the hashes; others may differ by a pixel here and there
+    bool textured;
+    bool showDebugMap;
+    uint64_t mapHash;
+    GoldenView* views;
+    int count;
+} GoldenSet;
+
+// Spawn at the four headings, then open cells spread over the map at axis and off-axis angles
+bool GoldenSetPickViews(GoldenSet* set, const Map* map, int count);
+bool GoldenSetLoad(GoldenSet* set, const char* path);
+bool GoldenSetSave(const GoldenSet* set, const char* path);
+void GoldenSetFree(GoldenSet* set);
+
+// Matching pixels dimmed to grey, differing ones red; returns the number that differ, or -1 on failure
+long GoldenWriteDiff(const Framebuffer* actual, const Framebuffer* expected, const char* path);
+
+#endif
@@ -0,0 +1,446 @@
+#include "headless.h"
+#include "clock.h"
+#include "dynres.h"
+#include "floorcast.h"
+#include "framebuffer.h"
+#include "golden.h"
+#include "inputlog.h"
+#include "mapfile.h"
+#include "pipeline.h"
+#include "profile.h"
+#include "raypacket.h"
+#include "render.h"
+#include "sprite.h"
+#include "temporal.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+bool LoadMapOption(Map* map, const HeadlessOptions* options) {
+    const char* path = options->mapPath;
+    double start = GetMonotonicSeconds();
+    if (!path && options->genWidth > 0) {
+        if (!MapGenerateSparse(map, options->genWidth, options->genHeight, options->genDensity, options->genSeed)) {
+            fprintf(stderr, "cannot generate %dx%d map\n", options->genWidth, options->genHeight);
+            return false;
+        }
+        printf("map: generated %dx%d  density %.3f  seed %u  in %.3f ms\n", map->width, map->height,
+               options->genDensity, options->genSeed, (GetMonotonicSeconds() - start) * 1000.0);
+        return true;
+    }
+    if (!path) return MapLoadDefault(map);
+
+    if (!MapLoadFile(map, path)) {
+        fprintf(stderr, "cannot load map %s\n", path);
+        return false;
+    }
+    printf("map: %s  %dx%d%s  loaded in %.3f ms\n", path, map->width, map->height, map->mapping ? " (mapped)" : "",
+           (GetMonotonicSeconds() - start) * 1000.0);
+    return true;
+}
+
+// The rings keep the most recent events only, so long runs report their tail
+static void PrintProfileSummary(int frames) {
+    ProfileSummary summary;
+    ProfileSummarize(frames < PROFILE_SUMMARY_FRAMES ? frames : PROFILE_SUMMARY_FRAMES, &summary);
+    printf("stages over last %d frames, ms/frame summed over %d threads:", summary.frames, summary.threads);
+    for (int s = 0; s < PROFILE_STAGE_COUNT; s++) {
+        if (summary.stageMs[s] > 0) printf("  %s %.3f", GetProfileStageName((ProfileStage)s), summary.stageMs[s]);
+    }
+    printf("\n");
+}
+
+// Stats and profile output shared by both frame loops
+static bool ReportRun(const HeadlessOptions* options, const ViewCache* viewCache, int frames) {
+    if (options->viewCache != VIEW_CACHE_OFF) ViewCachePrintStats(viewCache);
+    if (options->profile) PrintProfileSummary(frames);
+    if (options->tracePath && !ProfileWriteTrace(options->tracePath)) {
+        fprintf(stderr, "headless: failed to write %s\n", options->tracePath);
+        return false;
+    }
+    return true;
+}
+
+// The scripted camera as input events. The simulation applies them at its own
+// tick rate, so frames show whatever state the latest tick reached.
+static bool RunPipelinedFrames(const HeadlessOptions* options, const PipelineConfig* config, const Player* player) {
+    SimSnapshot initial = {
+        .player = *player,
+        .showDebugMap = options->showDebugMap,
+        .textured = options->textured,
+        .caster = options->caster,
+    };
+    Simulation* sim = SimulationStart(&config->level->map, &initial, options->tickRate);
+    RenderPipeline* pipeline = sim ? RenderPipelineStart(config, sim) : NULL;
+    if (!pipeline) {
+        fprintf(stderr, "headless: cannot start simulation and render threads\n");
+        SimulationStop(sim);
+        return false;
+    }
+
+    double start = GetMonotonicSeconds(), minFrame = 1e9, maxFrame = 0, previous = start;
+    SimSnapshot shown = {0};
+    for (int frame = 0; frame < options->frames; frame++) {
+        if (frame > 0) SimulationPostInput(sim, INPUT_TURN_LEFT);
+        if (frame > 0 && frame % 4 == 0) SimulationPostInput(sim, INPUT_FORWARD);
+        for (int i = 0; i < options->editsPerFrame; i++) SimulationPostInput(sim, INPUT_TOGGLE_DOOR);
+
+        uint64_t frameZone = ProfileBegin();
+        const Framebuffer* fb = RenderPipelineAcquire(pipeline, &shown);
+        if (options->dumpPrefix) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s%04d.ppm", options->dumpPrefix, frame);
+            if (!FramebufferWritePPM(fb, path)) fprintf(stderr, "headless: failed to write %s\n", path);
+        }
+        RenderPipelineRelease(pipeline);
+        ProfileEnd(PROFILE_FRAME, frameZone);
+        ProfileFrameMark();
+
+        double now = GetMonotonicSeconds();
+        if (now - previous < minFrame) minFrame = now - previous;
+        if (now - previous > maxFrame) maxFrame = now - previous;
+        previous = now;
+    }
+    double total = GetMonotonicSeconds() - start;
+    RenderPipelineStop(pipeline);
+    SimulationStop(sim);
+
+    if (options->frames > 0) {
+        printf("frames: %d  size: %dx%d  caster: %s  threads: %d  pipelined\n", options->frames, config->width,
+               config->height, GetCasterName(options->caster), ThreadPoolSize(config->pool));
+        printf("avg frame: %.3f ms  min %.3f ms  max %.3f ms  %.1f fps  last frame showed tick %u\n",
+               total * 1000.0 / options->frames, minFrame * 1000.0, maxFrame * 1000.0, options->frames / total,
+               shown.tick);
+        const DynamicResolution* resolution = config->resolution;
+        if (resolution) {
+            printf("dynamic resolution: budget %.3f ms  final %.3f x %.3f  changes %d\n", resolution->budgetMs,
+                   resolution->scaleX, resolution->scaleY, resolution->changes);
+        }
+    }
+    return true;
+}
+
+// Loads the golden file to check against, or picks the viewpoints of a new one
+static bool PrepareGolden(GoldenSet* golden, const HeadlessOptions* options, const Map* map, const Framebuffer* fb) {
+    const char* path = options->goldenPath;
+    if (options->goldenUpdate) {
+        *golden = (GoldenSet){
+            .width = fb->width,
+            .height = fb->height,
+            .caster = options->caster,
+            .textured = options->textured,
+            .showDebugMap = options->showDebugMap,
+            .mapHash = MapHashBits(map),
+        };
+        return GoldenSetPickViews(golden, map, GOLDEN_DEFAULT_VIEWS);
+    }
+    if (!GoldenSetLoad(golden, path)) {
+        fprintf(stderr, "headless: cannot read golden file %s\n", path);
+        return false;
+    }
+    if (golden->width != fb->width || golden->height != fb->height || golden->textured != options->textured ||
+        golden->showDebugMap != options->showDebugMap) {
+        fprintf(stderr, "headless: %s was written at %dx%d with textures %s and the map view %s\n", path,
+                golden->width, golden->height, golden->textured ? "on" : "off", golden->showDebugMap ? "on" : "off");
+        return false;
+    }
+    if (golden->mapHash != MapHashBits(map)) {
+        fprintf(stderr, "headless: %s was written for a different map\n", path);
+        return false;
+    }
+    if (golden->caster != options->caster) {
+        printf("golden: hashes are from the %s caster\n", GetCasterName(golden->caster));
+    }
+    return true;
+}
+
+// Records or checks the hash of one view. A mismatch is diffed against the
+// reference image when it was kept, else the frame is written for a look.
+static bool CheckGoldenFrame(GoldenSet* golden, int index, const Framebuffer* fb, const HeadlessOptions* options) {
+    GoldenView* view = &golden->views[index];
+    uint64_t hash = FramebufferHash(fb);
+    char imagePath[512], outPath[512];
+    snprintf(imagePath, sizeof(imagePath), "%s.%03d.ppm", options->goldenPath, index);
+    if (options->goldenUpdate) {
+        view->hash = hash;
+        if (!FramebufferWritePPM(fb, imagePath)) fprintf(stderr, "headless: failed to write %s\n", imagePath);
+        return true;
+    }
+    if (hash == view->hash) return true;
+
+    printf("golden: view %d at (%d, %d) %.3f: hash %016" PRIx64 ", expected %016" PRIx64 "\n", index, view->x,
+           view->y, view->angle, hash, view->hash);
+    Framebuffer expected;
+    if (FramebufferReadPPM(&expected, imagePath)) {
+        snprintf(outPath, sizeof(outPath), "%s.%03d.diff.ppm", options->goldenPath, index);
+        long differing = GoldenWriteDiff(fb, &expected, outPath);
+        FramebufferFree(&expected);
+        if (differing >= 0) {
+            printf("golden: %ld pixels differ, see %s\n", differing, outPath);
+            return false;
+        }
+    }
+    snprintf(outPath, sizeof(outPath), "%s.%03d.actual.ppm", options->goldenPath, index);
+    if (FramebufferWritePPM(fb, outPath)) {
+        printf("golden: no usable reference %s, frame written to %s\n", imagePath, outPath);
+    }
+    return false;
+}
+
+int RunHeadless(const HeadlessOptions* options) {
+    int status = 1;
+    Framebuffer fb = {0};
+    RayHit* hits = NULL;
+    Level level = {0};
+    RayTable rayTable = {0};
+    ViewCache viewCache = {0};
+    TextureAtlas atlas = {0};
+    SpriteSet sprites = {0};
+    PvsView pvsView = {0};
+    DynamicResolution resolution = {0};
+    TemporalCache temporal = {0};
+    InputLog replay = {0};
+    GoldenSet golden = {0};
+    ThreadPool* pool = NULL;
+
+    if (!FramebufferInit(&fb, options->width, options->height)) {
+        fprintf(stderr, "headless: cannot allocate %dx%d framebuffer\n", options->width, options->height);
+        goto done;
+    }
+    hits = malloc(sizeof(RayHit) * options->width);
+    if (!hits) goto done;
+    if (options->frameBudgetMs > 0 &&
+        !DynamicResolutionInit(&resolution, fb.width, fb.height, options->frameBudgetMs, options->scaleVertical)) {
+        goto done;
+    }
+
+    if (!LoadMapOption(&level.map, options) || !PrepareCaster(&level, options->caster)) goto done;
+    const Map* map = &level.map;
+    Player player = {.pos = {(float)map->spawnX, (float)map->spawnY}, .angle = 0.0f, .speed = 5.0f};
+    if (options->replayPath && !InputLogOpen(&replay, options->replayPath, map)) {
+        fprintf(stderr, "headless: cannot replay %s\n", options->replayPath);
+        goto done;
+    }
+    if (options->goldenPath && !PrepareGolden(&golden, options, map, &fb)) goto done;
+    // A replay runs for as long as it was recorded, a golden check once per view
+    int frames = options->replayPath ? (int)replay.header.frameCount : options->frames;
+    if (options->goldenPath) frames = golden.count;
+    int numRays = GetViewRayCount(fb.width, options->showDebugMap);
+    if (!RayTableInit(&rayTable, numRays, FOV)) goto done;
+
+    if (options->viewCache != VIEW_CACHE_OFF) {
+        if (!ViewCacheInit(&viewCache, &level, fb.width, options->viewDistance)) {
+            fprintf(stderr, "headless: cannot allocate view cache\n");
+            goto done;
+        }
+        if (options->viewCache == VIEW_CACHE_EAGER) ViewCacheBuildAll(&viewCache);
+    }
+    if (options->textured && !TextureAtlasGenerate(&atlas)) {
+        fprintf(stderr, "headless: cannot allocate texture atlas\n");
+        goto done;
+    }
+    if (options->sprites > 0 &&
+        (!SpriteSetInit(&sprites, map) || !SpriteSetScatter(&sprites, map, options->sprites, options->genSeed))) {
+        fprintf(stderr, "headless: cannot place %d sprites\n", options->sprites);
+        goto done;
+    }
+    pool = ThreadPoolCreate(options->threads, options->pinThreads);
+    if (options->profile || options->tracePath) ProfileSetEnabled(true);
+    if (options->pvs) {
+        char cachePath[512];
+        if (options->mapPath) snprintf(cachePath, sizeof(cachePath), "%s.pvs", options->mapPath);
+        if (!LevelEnsurePvs(&level, options->mapPath ? cachePath : NULL, pool) || !PvsViewInit(&pvsView, &level.pvs)) {
+            goto done;
+        }
+    }
+    if (options->pipelined) {
+        PipelineConfig config = {
+            .level = &level,
+            .viewCache = options->viewCache != VIEW_CACHE_OFF ? &viewCache : NULL,
+            .atlas = options->textured ? &atlas : NULL,
+            .sprites = &sprites,
+            .pvsView = options->pvs ? &pvsView : NULL,
+            .resolution = options->frameBudgetMs > 0 ? &resolution : NULL,
+            .pool = pool,
+            .viewDistance = options->viewDistance,
+            .width = fb.width,
+            .height = fb.height,
+        };
+        bool ran = RunPipelinedFrames(options, &config, &player);
+        if (ran && ReportRun(options, &viewCache, options->frames)) status = 0;
+        goto done;
+    }
+    ThreadPoolPinCaller(pool);
+    double castTime = 0, renderTime = 0, spriteTime = 0, minFrame = 1e9, maxFrame = 0, editTime = 0;
+    long visibleSprites = 0;
+    long edits = 0;
+    double scaleSum = 0, minScale = 1;
+    long castRays = 0;
+    uint32_t editRandom = options->genSeed ? options->genSeed : 1;
+    int goldenMismatches = 0;
+
+    for (int frame = 0; frame < frames; frame++) {
+        // Recorded input moves the camera as the game did, view toggles aside. Otherwise the scripted camera
+        // cycles through the four headings or turns continuously, stepping east every full turn.
+        bool fullTurn = frame > 0 && frame % 4 == 0 && !options->replayPath && !options->goldenPath;
+        if (options->goldenPath) {
+            player.pos = (Vec2){(float)golden.views[frame].x, (float)golden.views[frame].y};
+            player.angle = golden.views[frame].angle;
+        } else if (options->replayPath) {
+            InputFrame input;
+            if (!InputLogRead(&replay, &input)) {
+                fprintf(stderr, "headless: %s ends after %d frames\n", options->replayPath, frame);
+                goto done;
+            }
+            ApplyInputFrame(&input, replay.header.turnRate, &level, &player, NULL, NULL, NULL);
+        } else if (options->turnRate > 0) {
+            double turn = frame * options->turnRate / 60.0;
+            player.angle = (float)fmod(turn, 360.0);
+            fullTurn = frame > 0 && (int)(turn / 360.0) != (int)((frame - 1) * options->turnRate / 60.0 / 360.0);
+        } else {
+            player.angle = (float)((frame % 4) * 90);
+        }
+        if (fullTurn) {
+            int nextX = (int)player.pos.x + 1;
+            player.pos.x = MapIsSolid(map, nextX, (int)player.pos.y) ? (float)map->spawnX : (float)nextX;
+        }
+
+        // Doors opening and closing in front of the camera
+        for (int i = 0; i < options->editsPerFrame; i++) {
+            editRandom ^= editRandom << 13, editRandom ^= editRandom >> 17, editRandom ^= editRandom << 5;
+            int x = (int)player.pos.x + (int)(editRandom % 17) - 8;
+            int y = (int)player.pos.y + (int)((editRandom >> 8) % 17) - 8;
+            if (x == (int)player.pos.x && y == (int)player.pos.y) continue;
+            double editStart = GetMonotonicSeconds();
+            edits += LevelSetSolid(&level, x, y, !MapIsSolid(map, x, y));
+            editTime += GetMonotonicSeconds() - editStart;
+        }
+
+        uint64_t frameZone = ProfileBegin();
+        double start = GetMonotonicSeconds();
+        Framebuffer* view = options->frameBudgetMs > 0 ? DynamicResolutionBegin(&resolution, &fb) : &fb;
+        bool scaled = view != &fb;
+        numRays = GetViewRayCount(view->width, options->showDebugMap);
+        if (!RayTableEnsure(&rayTable, numRays, FOV)) goto done;
+        // Cached views keep no texture coordinates and hold full-width views only
+        bool cached = options->viewCache != VIEW_CACHE_OFF && !scaled && ViewCacheMatchesCaster(options->caster) &&
+                      !options->textured &&
+                      ViewCacheLookup(&viewCache, &player, options->showDebugMap, options->viewDistance, hits);
+        // The floor and sprites are drawn at the heading the walls were cast at
+        Player viewer = player;
+        uint64_t zone = ProfileBegin();
+        if (!cached && options->temporal) {
+            viewer.angle = TemporalCacheCast(&temporal, &level, &player, &rayTable, options->caster,
+                                             options->viewDistance, hits, pool);
+        } else if (!cached) {
+            CastView(&level, &player, &rayTable, options->caster, options->viewDistance, hits, pool);
+        }
+        ProfileEnd(PROFILE_CAST, zone);
+        double cast = GetMonotonicSeconds();
+        if (options->textured) {
+            // The floor pass covers the whole view, so only the map half needs clearing
+            if (options->showDebugMap) FramebufferClear(view, PIXEL_BLACK);
+            zone = ProfileBegin();
+            RenderFloorCeiling(view, &rayTable, &viewer, options->showDebugMap, &atlas, pool);
+            ProfileEnd(PROFILE_FLOOR, zone);
+            zone = ProfileBegin();
+            RenderViewTextured(view, hits, numRays, options->showDebugMap, map, &atlas);
+        } else {
+            zone = ProfileBegin();
+            FramebufferClear(view, PIXEL_BLACK);
+            RenderView(view, hits, numRays, options->showDebugMap);
+        }
+        ProfileEnd(PROFILE_WALLS, zone);
+        double spriteStart = GetMonotonicSeconds();
+        if (sprites.count > 0) {
+            zone = ProfileBegin();
+            if (options->pvs) PvsViewSetCell(&pvsView, &level.pvs, (int)player.pos.x, (int)player.pos.y);
+            SpriteSetCollectVisible(&sprites, &viewer, &rayTable, hits, options->pvs ? &pvsView : NULL);
+            RenderSprites(view, &sprites, &viewer, &rayTable, hits, options->showDebugMap);
+            ProfileEnd(PROFILE_SPRITES, zone);
+            visibleSprites += sprites.visibleCount;
+        }
+        double spriteEnd = GetMonotonicSeconds();
+        if (options->frameBudgetMs > 0) {
+            float scale = scaled ? resolution.scaleX * resolution.scaleY : 1.0f;
+            scaleSum += scale;
+            if (scale < minScale) minScale = scale;
+            DynamicResolutionUpdate(&resolution, (spriteEnd - start) * 1000.0);
+            DynamicResolutionEnd(&resolution, &fb, options->showDebugMap);
+        }
+        castRays += numRays;
+        if (options->showDebugMap) {
+            zone = ProfileBegin();
+            if (options->pvs) PvsViewSetCell(&pvsView, &level.pvs, (int)player.pos.x, (int)player.pos.y);
+            RenderDebugMap(&fb, map, &player, options->pvs ? &pvsView : NULL);
+            ProfileEnd(PROFILE_MINIMAP, zone);
+        }
+        double end = GetMonotonicSeconds();
+        ProfileEnd(PROFILE_FRAME, frameZone);
+        ProfileFrameMark();
+
+        castTime += cast - start;
+        renderTime += end - cast;
+        spriteTime += spriteEnd - spriteStart;
+        if (end - start < minFrame) minFrame = end - start;
+        if (end - start > maxFrame) maxFrame = end - start;
+
+        if (options->dumpPrefix) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s%04d.ppm", options->dumpPrefix, frame);
+            if (!FramebufferWritePPM(&fb, path)) fprintf(stderr, "headless: failed to write %s\n", path);
+        }
+        if (options->goldenPath && !CheckGoldenFrame(&golden, frame, &fb, options)) goldenMismatches++;
+    }
+
+    if (frames > 0) {
+        double total = castTime + renderTime;
+        printf("frames: %d  size: %dx%d  rays/frame: %d  caster: %s", frames, fb.width, fb.height,
+               (int)(castRays / frames), GetCasterName(options->caster));
+        if (options->caster == CASTER_PACKET) printf(" (%s)", GetPacketKernelName(GetPacketKernel()));
+        printf("  threads: %d%s\n", ThreadPoolSize(pool), options->textured ? "  textured" : "");
+        printf("avg frame: %.3f ms (cast %.3f ms, render %.3f ms)  min %.3f ms  max %.3f ms  %.1f fps\n",
+               total * 1000.0 / frames, castTime * 1000.0 / frames,
+               renderTime * 1000.0 / frames, minFrame * 1000.0, maxFrame * 1000.0, frames / total);
+        printf("view distance: %.1f  cast rate: %.3f Mrays/s\n", options->viewDistance, castRays / castTime / 1e6);
+        if (sprites.count > 0) {
+            printf("sprites: %d  avg visible %.1f  sprite stage %.3f ms\n", sprites.count,
+                   (double)visibleSprites / frames, spriteTime * 1000.0 / frames);
+        }
+        if (options->frameBudgetMs > 0) {
+            printf("dynamic resolution: budget %.3f ms  avg area %.3f  min %.3f  final %.3f x %.3f  changes %d\n",
+                   options->frameBudgetMs, scaleSum / frames, minScale, resolution.scaleX, resolution.scaleY,
+                   resolution.changes);
+        }
+        if (options->temporal) TemporalCachePrintStats(&temporal);
+        if (edits > 0) printf("edits: %ld  avg %.3f us/edit\n", edits, editTime * 1e6 / edits);
+    }
+    if (options->goldenPath && options->goldenUpdate) {
+        if (!GoldenSetSave(&golden, options->goldenPath)) {
+            fprintf(stderr, "headless: failed to write %s\n", options->goldenPath);
+            goto done;
+        }
+        printf("golden: wrote %d views to %s\n", golden.count, options->goldenPath);
+    } else if (options->goldenPath) {
+        printf("golden: %d/%d views match\n", golden.count - goldenMismatches, golden.count);
+    }
+    if (!ReportRun(options, &viewCache, frames) || goldenMismatches > 0) goto done;
+    status = 0;
+
+done:
+    InputLogClose(&replay);
+    GoldenSetFree(&golden);
+    ThreadPoolDestroy(pool);
+    PvsViewFree(&pvsView);
+    DynamicResolutionFree(&resolution);
+    TemporalCacheFree(&temporal);
+    SpriteSetFree(&sprites);
+    TextureAtlasFree(&atlas);
+    ViewCacheFree(&viewCache);
+    RayTableFree(&rayTable);
+    LevelFree(&level);
+    free(hits);
+    FramebufferFree(&fb);
+    return status;
+}
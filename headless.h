@@ -0,0 +1,46 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "viewcache.h"
+#include <stdbool.h>
+
+typedef struct {
+    const char* mapPath; // NULL = built-in layout, or a generated map when genWidth > 0
+    int genWidth;
+    int genHeight;
+    float genDensity;
+    uint32_t genSeed;
+    int frames;
+    int width;
+    int height;
+    const char* dumpPrefix; // Writes <prefix>NNNN.ppm per frame; NULL only reports timings
+    bool showDebugMap;
+    bool textured;
+    int sprites; // Scattered with genSeed
+    bool pvs; // Potentially visible sets, cached next to a map file as <map>.pvs
+    int editsPerFrame; // Cells near the camera toggled per frame with genSeed; the cell in front when pipelined
+    CasterKind caster;
+    float viewDistance;
+    ViewCacheMode viewCache;
+    int threads; // Cast threads including the caller; 0 = one per core
+    bool pinThreads;
+    bool pipelined; // Simulation and casting on their own threads, see pipeline.h
+    int tickRate; // Simulation ticks per second when pipelined; 0 = SIM_DEFAULT_TICK_RATE
+    float turnRate; // Scripted camera turns smoothly at this many degrees/s of 60 Hz frames; 0 = 90-degree steps
+    bool temporal; // Reuses last frame's columns while only turning, see temporal.h
+    double frameBudgetMs; // Dynamic resolution holds the view under this, see dynres.h; 0 = off
+    bool scaleVertical; // Dynamic resolution trades rows as well as columns
+    const char* replayPath; // Input log driving the camera in place of the script, see inputlog.h; NULL = none
+    const char* goldenPath; // Renders the file's viewpoints and compares frame hashes, see golden.h; NULL = none
+    bool goldenUpdate; // Picks viewpoints and writes goldenPath instead of checking it
+    bool profile; // Prints a stage breakdown
+    const char* tracePath; // Chrome trace_event JSON of the last frames; NULL = none
+} HeadlessOptions;
+
+// Loads mapPath with MapLoadFile, generates a sparse map, or falls back to the built-in layout
+bool LoadMapOption(Map* map, const HeadlessOptions* options);
+
+// Renders frames into an in-memory framebuffer without opening a window
+int RunHeadless(const HeadlessOptions* options);
+
+#endif
@@ -0,0 +1,124 @@
+#include "inputlog.h"
+#include <math.h>
+#include <string.h>
+
+static bool WriteVarint(FILE* file, uint32_t value) {
+    while (value >= 0x80) {
+        if (putc((int)(value | 0x80) & 0xFF, file) == EOF) return false;
+        value >>= 7;
+    }
+    return putc((int)value, file) != EOF;
+}
+
+static bool ReadVarint(FILE* file, uint32_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        int byte = getc(file);
+        if (byte == EOF) return false;
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool InputLogCreate(InputLog* log, const char* path, const Map* map, float turnRate) {
+    *log = (InputLog){.recording = true};
+    log->header = (InputLogHeader){
+        .magic = INPUT_LOG_MAGIC,
+        .version = INPUT_LOG_VERSION,
+        .turnRate = turnRate,
+        .mapHash = MapHashBits(map),
+    };
+    log->file = fopen(path, "wb");
+    if (log->file && fwrite(&log->header, sizeof(log->header), 1, log->file) == 1) return true;
+    if (log->file) fclose(log->file);
+    log->file = NULL;
+    return false;
+}
+
+bool InputLogOpen(InputLog* log, const char* path, const Map* map) {
+    *log = (InputLog){0};
+    log->file = fopen(path, "rb");
+    if (!log->file) return false;
+    bool ok = fread(&log->header, sizeof(log->header), 1, log->file) == 1 &&
+              memcmp(log->header.magic, INPUT_LOG_MAGIC, 4) == 0 && log->header.version == INPUT_LOG_VERSION;
+    if (ok && log->header.mapHash != MapHashBits(map)) {
+        fprintf(stderr, "%s: recorded on a different map\n", path);
+        ok = false;
+    }
+    if (ok) return true;
+    fclose(log->file);
+    log->file = NULL;
+    return false;
+}
+
+bool InputLogWrite(InputLog* log, const InputFrame* frame) {
+    uint32_t step = log->frames > 0 ? frame->frame - log->lastFrame : frame->frame;
+    bool ok = WriteVarint(log->file, step) && fwrite(&frame->deltaTime, sizeof(float), 1, log->file) == 1 &&
+              WriteVarint(log->file, frame->pressed) && WriteVarint(log->file, frame->held);
+    log->lastFrame = frame->frame;
+    log->frames++;
+    return ok;
+}
+
+bool InputLogRead(InputLog* log, InputFrame* frame) {
+    if (log->frames >= log->header.frameCount) return false;
+    uint32_t step, pressed, held;
+    if (!ReadVarint(log->file, &step) || fread(&frame->deltaTime, sizeof(float), 1, log->file) != 1 ||
+        !ReadVarint(log->file, &pressed) || !ReadVarint(log->file, &held)) {
+        return false;
+    }
+    frame->frame = log->frames > 0 ? log->lastFrame + step : step;
+    frame->pressed = (uint16_t)pressed;
+    frame->held = (uint16_t)held;
+    log->lastFrame = frame->frame;
+    log->frames++;
+    return true;
+}
+
+bool InputLogClose(InputLog* log) {
+    if (!log->file) return false;
+    bool ok = !ferror(log->file);
+    if (log->recording) {
+        log->header.frameCount = log->frames;
+        ok = fseek(log->file, 0, SEEK_SET) == 0 && fwrite(&log->header, sizeof(log->header), 1, log->file) == 1;
+    }
+    if (fclose(log->file) != 0) ok = false;
+    log->file = NULL;
+    return ok;
+}
+
+void ApplyInputFrame(const InputFrame* frame, float turnRate, Level* level, Player* player, bool* showDebugMap,
+                     bool* textured, CasterKind* caster) {
+    if (showDebugMap && InputFrameHas(frame->pressed, INPUT_TOGGLE_MAP)) *showDebugMap = !*showDebugMap;
+    if (caster) {
+        if (InputFrameHas(frame->pressed, INPUT_NEXT_CASTER)) *caster = (CasterKind)((*caster + 1) % CASTER_COUNT);
+        if (!PrepareCaster(level, *caster)) *caster = CASTER_DDA;
+    }
+    if (textured && InputFrameHas(frame->pressed, INPUT_TOGGLE_TEXTURES)) *textured = !*textured;
+
+    // Grid-based movement (1.0 unit steps)
+    float forwardX = 0.0f, forwardY = 0.0f, backwardX = 0.0f, backwardY = 0.0f;
+    GetMovementDirections(player->angle, &forwardX, &forwardY, &backwardX, &backwardY);
+    if (InputFrameHas(frame->pressed, INPUT_FORWARD)) StepPlayer(player, &level->map, true);
+    if (InputFrameHas(frame->pressed, INPUT_BACKWARD)) StepPlayer(player, &level->map, false);
+    if (InputFrameHas(frame->pressed, INPUT_TOGGLE_DOOR)) { // Open or close the cell in front, like a door
+        int doorX = (int)(player->pos.x + forwardX * CELL_SIZE);
+        int doorY = (int)(player->pos.y + forwardY * CELL_SIZE);
+        LevelSetSolid(level, doorX, doorY, !MapIsSolid(&level->map, doorX, doorY));
+    }
+
+    bool left = InputFrameHas(frame->held, INPUT_TURN_LEFT);
+    bool right = InputFrameHas(frame->held, INPUT_TURN_RIGHT);
+    if (turnRate > 0) {
+        // Smooth rotation while held, snapped back to the grid headings on release
+        if (left) player->angle += turnRate * frame->deltaTime;
+        if (right) player->angle -= turnRate * frame->deltaTime;
+        player->angle = fmodf(player->angle + 360.0f, 360.0f);
+        if (!left && !right) player->angle = fmodf(roundf(player->angle / 90.0f) * 90.0f, 360.0f);
+    } else {
+        // Discrete 90-degree rotation
+        if (InputFrameHas(frame->pressed, INPUT_TURN_LEFT)) TurnPlayer(player, true);
+        if (InputFrameHas(frame->pressed, INPUT_TURN_RIGHT)) TurnPlayer(player, false);
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include "sim.h"
+#include <stdio.h>
+
+// Recorded player input: one record per frame with the frame's time delta
+// and the actions whose keys went down or were held. Replaying a log through
+// ApplyInputFrame on the same map reproduces the session without a keyboard.
+// Records are a varint frame step, the raw float delta and two varint masks,
+// so a frame usually takes 7 bytes.
+#define INPUT_LOG_MAGIC "RINP"
+#define INPUT_LOG_VERSION 1
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t frameCount; // Filled in when the recording is closed
+    float turnRate; // Turning mode of the session, see ApplyInputFrame
+    uint64_t mapHash; // Occupancy when the session started
+} InputLogHeader;
+
+// Bit n of each mask is InputAction n
+typedef struct {
+    uint32_t frame;
+    float deltaTime; // GetFrameTime() of the frame
+    uint16_t pressed; // Keys that went down this frame
+    uint16_t held; // Keys that were down during this frame
+} InputFrame;
+
+typedef struct {
+    FILE* file;
+    bool recording;
+    InputLogHeader header;
+    uint32_t frames; // Records written or read so far
+    uint32_t lastFrame;
+} InputLog;
+
+bool InputLogCreate(InputLog* log, const char* path, const Map* map, float turnRate);
+// Fails for logs of another map, since the same input would go elsewhere
+bool InputLogOpen(InputLog* log, const char* path, const Map* map);
+bool InputLogWrite(InputLog* log, const InputFrame* frame);
+// Returns false at the end of the log
+bool InputLogRead(InputLog* log, InputFrame* frame);
+// Completes the header of a recording
+bool InputLogClose(InputLog* log);
+
+static inline bool InputFrameHas(uint16_t mask, InputAction action) {
+    return (mask & (1u << action)) != 0;
+}
+
+// The game's response to one frame of input: grid steps, doors, turns
+// (smooth at turnRate degrees per second while held, else 90-degree steps)
+// and the view toggles. The level is edited in place; NULL view settings
+// ignore their toggles.
+void ApplyInputFrame(const InputFrame* frame, float turnRate, Level* level, Player* player, bool* showDebugMap,
+                     bool* textured, CasterKind* caster);
+
+#endif
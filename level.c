@@ -0,0 +1,86 @@
+#include "level.h"
+#include "clock.h"
+#include <stdio.h>
+
+void LevelFree(Level* level) {
+    if (level->hasPyramid) PyramidFree(&level->pyramid);
+    level->hasPyramid = false;
+    if (level->hasField) DistanceFieldFree(&level->field);
+    level->hasField = false;
+    if (level->hasPvs) PvsFree(&level->pvs);
+    level->hasPvs = false;
+    MapFree(&level->map);
+}
+
+static FILE* GetLog(const Level* level) {
+    return level->log ? level->log : stdout;
+}
+
+bool LevelEnsurePyramid(Level* level) {
+    if (level->hasPyramid) return true;
+
+    double start = GetMonotonicSeconds();
+    if (!PyramidBuild(&level->pyramid, &level->map)) {
+        fprintf(stderr, "cannot allocate empty-space pyramid\n");
+        return false;
+    }
+    level->hasPyramid = true;
+    fprintf(GetLog(level), "pyramid: %dx%d + %dx%d blocks  built in %.3f ms\n", level->pyramid.fineWidth,
+            level->pyramid.fineHeight, level->pyramid.coarseWidth, level->pyramid.coarseHeight,
+            (GetMonotonicSeconds() - start) * 1000.0);
+    return true;
+}
+
+bool LevelEnsureField(Level* level) {
+    if (level->hasField) return true;
+
+    double start = GetMonotonicSeconds();
+    if (!DistanceFieldBuild(&level->field, &level->map)) {
+        fprintf(stderr, "cannot allocate distance field\n");
+        return false;
+    }
+    level->hasField = true;
+    fprintf(GetLog(level), "distance field: %dx%d  built in %.3f ms\n", level->field.width, level->field.height,
+            (GetMonotonicSeconds() - start) * 1000.0);
+    return true;
+}
+
+bool LevelEnsurePvs(Level* level, const char* cachePath, ThreadPool* pool) {
+    if (level->hasPvs) return true;
+
+    double start = GetMonotonicSeconds();
+    if (cachePath && PvsLoad(&level->pvs, &level->map, cachePath)) {
+        level->hasPvs = true;
+        fprintf(GetLog(level), "pvs: %s  radius %d  %.1f KiB  loaded in %.3f ms\n", cachePath, level->pvs.radius,
+                level->pvs.dataSize / 1024.0, (GetMonotonicSeconds() - start) * 1000.0);
+        return true;
+    }
+    if (!PvsBuild(&level->pvs, &level->map, PVS_DEFAULT_RADIUS, pool)) {
+        fprintf(stderr, "cannot build potentially visible sets\n");
+        return false;
+    }
+    level->hasPvs = true;
+    fprintf(GetLog(level), "pvs: radius %d  %.1f KiB  built in %.3f ms\n", level->pvs.radius,
+            level->pvs.dataSize / 1024.0, (GetMonotonicSeconds() - start) * 1000.0);
+    if (cachePath && !PvsSave(&level->pvs, cachePath)) fprintf(stderr, "cannot write %s\n", cachePath);
+    return true;
+}
+
+bool LevelSetSolid(Level* level, int x, int y, bool solid) {
+    if (x < 0 || y < 0 || x >= level->map.width || y >= level->map.height) return false;
+    bool wasSolid = MapIsSolid(&level->map, x, y);
+    if (wasSolid == solid) return false;
+    MapSetSolid(&level->map, x, y, solid);
+    if (level->hasPyramid) PyramidUpdateCell(&level->pyramid, x, y, wasSolid, solid);
+    if (level->hasField) DistanceFieldUpdateCell(&level->field, &level->map, x, y);
+    if (level->hasPvs) PvsMarkEdit(&level->pvs, x, y);
+    level->edits[level->editCount % LEVEL_EDIT_LOG] = (LevelEdit){x, y};
+    level->editCount++;
+    return true;
+}
+
+bool LevelGetEdit(const Level* level, uint32_t index, LevelEdit* edit) {
+    if (index >= level->editCount || level->editCount - index > LEVEL_EDIT_LOG) return false;
+    *edit = level->edits[index % LEVEL_EDIT_LOG];
+    return true;
+}
@@ -0,0 +1,46 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include "distfield.h"
+#include "pvs.h"
+#include "pyramid.h"
+#include <stdio.h>
+
+// Cell edits are kept in a ring so caches outside the level (views, minimaps)
+// can catch up on the cells that changed since they last looked
+#define LEVEL_EDIT_LOG 1024
+
+typedef struct {
+    int x;
+    int y;
+} LevelEdit;
+
+// A map plus the acceleration structures derived from it. Derived data is
+// built on demand by the casters that need it and must be kept in step with
+// any edit to the map.
+typedef struct {
+    Map map;
+    Pyramid pyramid;
+    bool hasPyramid;
+    DistanceField field;
+    bool hasField;
+    Pvs pvs;
+    bool hasPvs;
+    LevelEdit edits[LEVEL_EDIT_LOG]; // Edit i is at i % LEVEL_EDIT_LOG
+    uint32_t editCount;
+    FILE* log; // Build and load reports; NULL = stdout
+} Level;
+
+void LevelFree(Level* level);
+bool LevelEnsurePyramid(Level* level);
+bool LevelEnsureField(Level* level);
+// Loads the sets from cachePath when they match the map, otherwise builds them
+// and writes them there (cachePath may be NULL)
+bool LevelEnsurePvs(Level* level, const char* cachePath, ThreadPool* pool);
+// Changes one cell and patches the derived structures in place; returns false
+// for the border or when the cell already was that way
+bool LevelSetSolid(Level* level, int x, int y, bool solid);
+// Gets edit index (editCount - 1 is the latest); fails once the ring has dropped it
+bool LevelGetEdit(const Level* level, uint32_t index, LevelEdit* edit);
+
+#endif
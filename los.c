@@ -0,0 +1,70 @@
+#include "los.h"
+#include "raypacket.h"
+#include <math.h>
+
+// Queries are repacked into structure-of-arrays batches for the packet kernel
+#define LOS_BATCH 256
+// A packet runs until its longest lane ends, so batches are ordered by the
+// number of cells each segment crosses (capped) before they are packed
+#define LOS_LENGTH_BUCKETS 64
+
+typedef struct {
+    const Map* map;
+    const LosSegment* segments;
+    LosResult* results;
+} LosJob;
+
+static void QueryLineOfSightRange(void* context, int begin, int end) {
+    const LosJob* job = context;
+    const Map* map = job->map;
+    float originX[LOS_BATCH], originY[LOS_BATCH], dirX[LOS_BATCH], dirY[LOS_BATCH];
+    bool inside[LOS_BATCH];
+    RayHit hits[LOS_BATCH];
+
+    for (int base = begin; base < end; base += LOS_BATCH) {
+        int count = end - base < LOS_BATCH ? end - base : LOS_BATCH;
+        int bucketStart[LOS_LENGTH_BUCKETS + 1] = {0};
+        uint8_t bucket[LOS_BATCH];
+        for (int i = 0; i < count; i++) {
+            const LosSegment* segment = &job->segments[base + i];
+            int cells = (int)(fabsf(segment->toX - segment->fromX) + fabsf(segment->toY - segment->fromY));
+            bucket[i] = cells >= 0 && cells < LOS_LENGTH_BUCKETS ? (uint8_t)cells : LOS_LENGTH_BUCKETS - 1;
+            bucketStart[bucket[i] + 1]++;
+        }
+        for (int b = 0; b < LOS_LENGTH_BUCKETS; b++) bucketStart[b + 1] += bucketStart[b];
+
+        int order[LOS_BATCH];
+        for (int i = 0; i < count; i++) {
+            int slot = bucketStart[bucket[i]]++;
+            const LosSegment* segment = &job->segments[base + i];
+            order[slot] = i;
+            inside[slot] = segment->fromX >= 0.0f && segment->fromY >= 0.0f && segment->fromX < map->width &&
+                           segment->fromY < map->height;
+            // The traversal needs an origin inside the map; outside ones trace a stationary dummy ray
+            originX[slot] = inside[slot] ? segment->fromX : 0.5f;
+            originY[slot] = inside[slot] ? segment->fromY : 0.5f;
+            dirX[slot] = inside[slot] ? segment->toX - segment->fromX : 0.0f;
+            dirY[slot] = inside[slot] ? segment->toY - segment->fromY : 0.0f;
+        }
+
+        // Directions span the whole segment, so distance 1 is the target
+        CastRayPacket(map, originX, originY, 1, dirX, dirY, 1.0f, count, hits);
+
+        for (int i = 0; i < count; i++) {
+            LosResult* result = &job->results[base + order[i]];
+            float length = sqrtf(dirX[i] * dirX[i] + dirY[i] * dirY[i]);
+            if (!inside[i]) {
+                *result = (LosResult){false, 0.0f, -1, -1};
+            } else if (hits[i].kind == RAY_HIT_WALL) {
+                *result = (LosResult){false, hits[i].distance * length, hits[i].mapX, hits[i].mapY};
+            } else {
+                *result = (LosResult){true, length, -1, -1};
+            }
+        }
+    }
+}
+
+void QueryLineOfSight(const Map* map, const LosSegment* segments, int count, LosResult* results, ThreadPool* pool) {
+    LosJob job = {map, segments, results};
+    ThreadPoolRun(pool, QueryLineOfSightRange, &job, count);
+}
@@ -0,0 +1,28 @@
+#ifndef LOS_H
+#define LOS_H
+
+#include "raycast.h"
+
+// Line-of-sight queries for game logic. Segments are in map cell units, the
+// same space the casters use (cell (x, y) covers [x, x + 1) x [y, y + 1), so
+// a player stands at pos + PLAYER_OFFSET). Each segment is traced with the
+// packet DDA, which matches the rendering traversal cell for cell.
+typedef struct {
+    float fromX;
+    float fromY;
+    float toX;
+    float toY;
+} LosSegment;
+
+typedef struct {
+    bool visible; // No wall between from and to; a target inside a wall cell is hidden by that cell
+    float distance; // From `from` to the first wall crossed, or the segment length when visible
+    int mapX; // Blocking cell, -1 when visible
+    int mapY;
+} LosResult;
+
+// Answers count queries, spread over pool (may be NULL). Segments starting
+// outside the map come back not visible at distance 0.
+void QueryLineOfSight(const Map* map, const LosSegment* segments, int count, LosResult* results, ThreadPool* pool);
+
+#endif
@@ -1,171 +1,512 @@
 #include "raylib.h"
+#include "clock.h"
+#include "dynres.h"
+#include "floorcast.h"
+#include "headless.h"
+#include "inputlog.h"
+#include "mapfile.h"
+#include "pipeline.h"
+#include "profile.h"
+#include "raycast.h"
+#include "raypacket.h"
+#include "render.h"
+#include "sprite.h"
+#include "temporal.h"
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #define SCREEN_WIDTH 800
 #define SCREEN_HEIGHT 600
-#define MAP_WIDTH 8
-#define MAP_HEIGHT 8
-#define FOV 60.0f
-#define CELL_SIZE 1.0f
-#define PLAYER_OFFSET 0.5f
-
-char map[MAP_HEIGHT][MAP_WIDTH] = {{'w', 'w', 'w', 'w', 'w', 'w', 'w', 'w'},
-                                   {'w', '0', '0', '0', '0', '0', '0', 'w'},
-                                   {'w', '0', 'w', '0', 'w', '0', '0', 'w'},
-                                   {'w', '0', '0', '0', '0', 'w', '0', 'w'},
-                                   {'w', '0', 'w', '0', 'w', '0', '0', 'w'},
-                                   {'w', '0', '0', 'w', '0', '0', '0', 'w'},
-                                   {'w', '0', '0', '0', '0', '0', '0', 'w'},
-                                   {'w', 'w', 'w', 'w', 'w', 'w', 'w', 'w'}};
-
-typedef struct {
-    Vector2 pos; // Integer grid position (0, 1, 2, etc.)
-    float angle; // Only 0, 90, 180, 270
-    float speed; // Unused, kept for potential future use
-} Player;
-
-bool IsPointInMap(float x, float y) {
-    return x >= 0 && x < MAP_WIDTH && y >= 0 && y < MAP_HEIGHT;
+
+static void PrintUsage(const char* program) {
+    printf("usage: %s [--headless] [--frames N] [--width W] [--height H] [--dump PREFIX] [--no-map]\n"
+           "          [--framebuffer] [--textures] [--view-cache] [--view-cache-lazy] [--threads N] [--pin]\n"
+           "          [--caster dda|march|packet|hier|field|fixed] [--simd scalar|sse2|avx2|avx512]\n"
+           "          [--view-distance D] [--map FILE] [--gen-sparse W H] [--density F] [--seed N]\n"
+           "          [--sprites N] [--pvs] [--edits N] [--pipelined] [--tick-rate N] [--profile] [--trace FILE]\n"
+           "          [--budget MS] [--scale-vertical] [--turn-rate DEG] [--temporal] [--export-map FILE]\n"
+           "          [--record FILE] [--replay FILE] [--golden FILE] [--golden-update]\n",
+           program);
+}
+
+// Stage breakdown from the profiler rings, drawn top-right over the frame
+static void DrawProfileOverlay(void) {
+    ProfileSummary summary;
+    ProfileSummarize(PROFILE_SUMMARY_FRAMES, &summary);
+    if (summary.frames == 0) return;
+
+    int x = SCREEN_WIDTH - 250;
+    int y = 10;
+    DrawRectangle(x - 10, y - 5, 250, 20 + PROFILE_STAGE_COUNT * 18, Fade(BLACK, 0.7f));
+    DrawText(TextFormat("ms/frame over %d frames, %d threads", summary.frames, summary.threads), x, y, 10, RAYWHITE);
+    double frameMs = summary.stageMs[PROFILE_FRAME] > 0 ? summary.stageMs[PROFILE_FRAME] : 1.0;
+    for (int s = 0; s < PROFILE_STAGE_COUNT; s++) {
+        y += 18;
+        // Chunk stages add up time on every thread, so they can run past the frame bar
+        int bar = (int)(120 * summary.stageMs[s] / frameMs);
+        DrawRectangle(x + 110, y, bar < 120 ? bar : 120, 12, s == PROFILE_FRAME ? SKYBLUE : ORANGE);
+        DrawText(TextFormat("%-10s %6.3f", GetProfileStageName((ProfileStage)s), summary.stageMs[s]), x, y, 10,
+                 RAYWHITE);
+    }
+}
+
+// F3 toggles the profiler overlay, F2 writes a trace
+static void HandleProfileKeys(bool* showProfile, const char* tracePath) {
+    if (IsKeyPressed(KEY_F3)) *showProfile = !*showProfile;
+    if (IsKeyPressed(KEY_F2)) {
+        if (ProfileWriteTrace(tracePath)) {
+            printf("trace: wrote %s\n", tracePath);
+        } else {
+            fprintf(stderr, "trace: failed to write %s\n", tracePath);
+        }
+    }
 }
 
-void GetMovementDirections(float angle, float* forwardX, float* forwardY, float* backwardX, float* backwardY) {
-    // Define forward and backward directions based on angle (YOUR CORRECTED VERSION)
-    if (angle == 0.0f) { // East
-        *forwardX = 1.0f;
-        *forwardY = 0.0f;
-        *backwardX = -1.0f;
-        *backwardY = 0.0f;
-    } else if (angle == 90.0f) { // North (up, -Y)
-        *forwardX = 0.0f;
-        *forwardY = 1.0f; // Forward is up (decreasing Y) // fixed
-        *backwardX = 0.0f;
-        *backwardY = -1.0f; // Backward is down (increasing Y) // fixed
-    } else if (angle == 180.0f) { // West
-        *forwardX = -1.0f;
-        *forwardY = 0.0f;
-        *backwardX = 1.0f;
-        *backwardY = 0.0f;
-    } else if (angle == 270.0f) { // South (down, +Y)
-        *forwardX = 0.0f;
-        *forwardY = -1.0f; // Forward is down (increasing Y) // fixed
-        *backwardX = 0.0f;
-        *backwardY = 1.0f; // Backward is up (decreasing Y) // fixed
+static const struct {
+    int key;
+    InputAction action;
+} keyBindings[] = {
+    {KEY_W, INPUT_FORWARD},     {KEY_S, INPUT_BACKWARD},    {KEY_A, INPUT_TURN_LEFT},
+    {KEY_D, INPUT_TURN_RIGHT},  {KEY_E, INPUT_TOGGLE_DOOR}, {KEY_M, INPUT_TOGGLE_MAP},
+    {KEY_C, INPUT_NEXT_CASTER}, {KEY_T, INPUT_TOGGLE_TEXTURES},
+};
+
+static InputFrame PollInputFrame(uint32_t frame) {
+    InputFrame input = {.frame = frame, .deltaTime = GetFrameTime()};
+    for (size_t i = 0; i < sizeof(keyBindings) / sizeof(keyBindings[0]); i++) {
+        if (IsKeyPressed(keyBindings[i].key)) input.pressed |= (uint16_t)(1u << keyBindings[i].action);
+        if (IsKeyDown(keyBindings[i].key)) input.held |= (uint16_t)(1u << keyBindings[i].action);
     }
+    return input;
 }
 
-int main(void) {
+// Window loop with the simulation and the casting on their own threads: this
+// thread only turns keys into input events and uploads finished frames, so a
+// slow cast no longer holds up input
+static void RunPipelinedWindow(const HeadlessOptions* options, const PipelineConfig* config, const Player* player,
+                               Texture2D fbTexture, bool showProfile, const char* tracePath) {
+    SimSnapshot initial = {
+        .player = *player,
+        .showDebugMap = options->showDebugMap,
+        .textured = options->textured,
+        .caster = options->caster,
+    };
+    Simulation* sim = SimulationStart(&config->level->map, &initial, options->tickRate);
+    RenderPipeline* pipeline = sim ? RenderPipelineStart(config, sim) : NULL;
+    if (!pipeline) {
+        fprintf(stderr, "cannot start simulation and render threads\n");
+        SimulationStop(sim);
+        return;
+    }
+
+    while (!WindowShouldClose()) {
+        uint64_t frameZone = ProfileBegin();
+        uint64_t zone = ProfileBegin();
+        HandleProfileKeys(&showProfile, tracePath);
+        for (size_t i = 0; i < sizeof(keyBindings) / sizeof(keyBindings[0]); i++) {
+            if (IsKeyPressed(keyBindings[i].key)) SimulationPostInput(sim, keyBindings[i].action);
+        }
+        ProfileEnd(PROFILE_INPUT, zone);
+
+        SimSnapshot shown;
+        const Framebuffer* fb = RenderPipelineAcquire(pipeline, &shown);
+        float scaleX, scaleY;
+        RenderPipelineGetScale(pipeline, &scaleX, &scaleY);
+        zone = ProfileBegin();
+        UpdateTexture(fbTexture, fb->pixels);
+        // Once uploaded the worker may draw the next frame into it while this one is presented
+        RenderPipelineRelease(pipeline);
+        BeginDrawing();
+        ClearBackground(BLACK);
+        DrawTexture(fbTexture, 0, 0, WHITE);
+        DrawFPS(10, 10);
+        DrawText(TextFormat("%s / pipelined%s", GetCasterName(shown.caster), shown.textured ? " / textured" : ""), 10,
+                 30, 20, GREEN);
+        if (config->resolution) DrawText(TextFormat("scale %.2f x %.2f", scaleX, scaleY), 10, 55, 20, GREEN);
+        if (showProfile) DrawProfileOverlay();
+        EndDrawing();
+        ProfileEnd(PROFILE_PRESENT, zone);
+        ProfileEnd(PROFILE_FRAME, frameZone);
+        ProfileFrameMark();
+    }
+    RenderPipelineStop(pipeline);
+    SimulationStop(sim);
+}
+
+// Converts between map formats: .txt is written as text, anything else as binary
+static int ExportMap(const HeadlessOptions* source, const char* exportPath) {
+    Map map = {0};
+    if (!LoadMapOption(&map, source)) return 1;
+
+    size_t length = strlen(exportPath);
+    bool text = length >= 4 && strcmp(exportPath + length - 4, ".txt") == 0;
+    bool ok = text ? MapSaveText(&map, exportPath) : MapSaveBinary(&map, exportPath);
+    if (!ok) fprintf(stderr, "cannot write %s\n", exportPath);
+    MapFree(&map);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    HeadlessOptions headless = {.frames = 100,
+                                .width = SCREEN_WIDTH,
+                                .height = SCREEN_HEIGHT,
+                                .showDebugMap = true,
+                                .viewDistance = MAX_RAY_DISTANCE,
+                                .threads = 1,
+                                .genDensity = 0.01f,
+                                .genSeed = 1};
+    bool runHeadless = false;
+    bool useFramebuffer = false;
+    const char* exportPath = NULL;
+    const char* recordPath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            runHeadless = true;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            headless.frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            headless.width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            headless.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+            headless.dumpPrefix = argv[++i];
+        } else if (strcmp(argv[i], "--no-map") == 0) {
+            headless.showDebugMap = false;
+        } else if (strcmp(argv[i], "--caster") == 0 && i + 1 < argc) {
+            if (!ParseCasterName(argv[++i], &headless.caster)) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--simd") == 0 && i + 1 < argc) {
+            PacketKernel kernel;
+            if (!ParsePacketKernelName(argv[++i], &kernel)) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            SetPacketKernel(kernel);
+        } else if (strcmp(argv[i], "--framebuffer") == 0) {
+            useFramebuffer = true;
+        } else if (strcmp(argv[i], "--textures") == 0) {
+            headless.textured = true;
+        } else if (strcmp(argv[i], "--sprites") == 0 && i + 1 < argc) {
+            headless.sprites = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--view-cache") == 0) {
+            headless.viewCache = VIEW_CACHE_EAGER;
+        } else if (strcmp(argv[i], "--view-cache-lazy") == 0) {
+            headless.viewCache = VIEW_CACHE_LAZY;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            headless.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            headless.pinThreads = true;
+        } else if (strcmp(argv[i], "--view-distance") == 0 && i + 1 < argc) {
+            headless.viewDistance = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+            headless.mapPath = argv[++i];
+        } else if (strcmp(argv[i], "--gen-sparse") == 0 && i + 2 < argc) {
+            headless.genWidth = atoi(argv[++i]);
+            headless.genHeight = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--density") == 0 && i + 1 < argc) {
+            headless.genDensity = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            headless.genSeed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--pvs") == 0) {
+            headless.pvs = true;
+        } else if (strcmp(argv[i], "--edits") == 0 && i + 1 < argc) {
+            headless.editsPerFrame = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pipelined") == 0) {
+            headless.pipelined = true;
+        } else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            headless.tickRate = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+            headless.frameBudgetMs = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--scale-vertical") == 0) {
+            headless.scaleVertical = true;
+        } else if (strcmp(argv[i], "--turn-rate") == 0 && i + 1 < argc) {
+            headless.turnRate = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--temporal") == 0) {
+            headless.temporal = true;
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            headless.profile = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            headless.tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            headless.replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+            headless.goldenPath = argv[++i];
+        } else if (strcmp(argv[i], "--golden-update") == 0) {
+            headless.goldenUpdate = true;
+        } else if (strcmp(argv[i], "--export-map") == 0 && i + 1 < argc) {
+            exportPath = argv[++i];
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Recording needs a keyboard, and the pipelined simulation keeps its own time
+    bool badInputLog = (recordPath && (runHeadless || headless.replayPath)) ||
+                       ((recordPath || headless.replayPath) && headless.pipelined);
+    // Golden frames are checked from fixed viewpoints in the headless frame loop
+    bool badGolden = headless.goldenPath ? !runHeadless || headless.pipelined || headless.replayPath
+                                         : headless.goldenUpdate;
+    if ((headless.genWidth > 0 && headless.genHeight <= 0) || badInputLog || badGolden) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    if (exportPath) return ExportMap(&headless, exportPath);
+    if (runHeadless) return RunHeadless(&headless);
+
+    Level level = {0};
+    if (!LoadMapOption(&level.map, &headless)) return 1;
+    Map* map = &level.map;
+    // Logs hold the occupancy they start from, so they are opened before any edit
+    InputLog inputLog = {0};
+    if ((recordPath && !InputLogCreate(&inputLog, recordPath, map, headless.turnRate)) ||
+        (headless.replayPath && !InputLogOpen(&inputLog, headless.replayPath, map))) {
+        fprintf(stderr, "cannot open input log %s\n", recordPath ? recordPath : headless.replayPath);
+        LevelFree(&level);
+        return 1;
+    }
+    // A replay turns the way the recorded session did
+    float turnRate = headless.replayPath ? inputLog.header.turnRate : headless.turnRate;
+    uint32_t inputFrame = 0;
+
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Simple Raycasting FPS");
     SetTargetFPS(60);
 
     Player player = {
-        .pos = {1.0f, 1.0f}, // Start at grid position (1, 1)
+        .pos = {(float)map->spawnX, (float)map->spawnY}, // Start at the map's spawn cell
         .angle = 0.0f, // Start facing east
         .speed = 5.0f // Unused
     };
 
-    bool showDebugMap = true;
+    bool showDebugMap = headless.showDebugMap;
+    bool textured = headless.textured;
+    CasterKind caster = headless.caster;
+    RayHit hits[SCREEN_WIDTH];
+    RayTable rayTable = {0};
+    TemporalCache temporal = {0};
+    ViewCache viewCache = {0};
+    Framebuffer fb = {0};
+    TextureAtlas atlas = {0};
+    SpriteSet sprites = {0};
+    PvsView pvsView = {0};
+    DynamicResolution resolution = {0};
+    Texture2D fbTexture = {0};
+    int status = 1;
+    ThreadPool* pool = ThreadPoolCreate(headless.threads, headless.pinThreads);
 
-    while (!WindowShouldClose()) {
-        float deltaTime = GetFrameTime();
+    if (headless.viewCache != VIEW_CACHE_OFF) {
+        if (!ViewCacheInit(&viewCache, &level, SCREEN_WIDTH, headless.viewDistance)) goto done;
+        if (headless.viewCache == VIEW_CACHE_EAGER) {
+            ViewCacheBuildAll(&viewCache);
+            ViewCachePrintStats(&viewCache);
+        }
+    }
 
-        if (IsKeyPressed(KEY_M)) showDebugMap = !showDebugMap;
+    // CPU composition target, uploaded with a single UpdateTexture per frame
+    if (!FramebufferInit(&fb, SCREEN_WIDTH, SCREEN_HEIGHT) || !TextureAtlasGenerate(&atlas)) goto done;
+    if (headless.sprites > 0 &&
+        (!SpriteSetInit(&sprites, map) || !SpriteSetScatter(&sprites, map, headless.sprites, headless.genSeed))) {
+        goto done;
+    }
+    char pvsPath[512];
+    if (headless.mapPath) snprintf(pvsPath, sizeof(pvsPath), "%s.pvs", headless.mapPath);
+    if (headless.pvs &&
+        (!LevelEnsurePvs(&level, headless.mapPath ? pvsPath : NULL, pool) || !PvsViewInit(&pvsView, &level.pvs))) {
+        goto done;
+    }
+    // The scaled view is only stretched on the CPU framebuffer
+    bool dynamic = headless.frameBudgetMs > 0;
+    if (dynamic && !DynamicResolutionInit(&resolution, SCREEN_WIDTH, SCREEN_HEIGHT, headless.frameBudgetMs,
+                                          headless.scaleVertical)) {
+        goto done;
+    }
+    Image blank = GenImageColor(SCREEN_WIDTH, SCREEN_HEIGHT, BLACK);
+    fbTexture = LoadTextureFromImage(blank);
+    UnloadImage(blank);
 
-        // Grid-based movement (1.0 unit steps)
-        float forwardX, forwardY, backwardX, backwardY;
-        GetMovementDirections(player.angle, &forwardX, &forwardY, &backwardX, &backwardY);
+    // Recording is cheap enough to leave on; F3 shows the overlay and F2 writes a trace
+    ProfileSetEnabled(true);
+    bool showProfile = headless.profile;
+    const char* tracePath = headless.tracePath ? headless.tracePath : "trace.json";
 
-        if (IsKeyPressed(KEY_W)) { // Move forward
-            float newX = player.pos.x + forwardX * CELL_SIZE;
-            float newY = player.pos.y + forwardY * CELL_SIZE;
-            if (IsPointInMap(newX, newY) && map[(int)newY][(int)newX] != 'w') {
-                player.pos.x = newX;
-                player.pos.y = newY;
-            }
-        }
-        if (IsKeyPressed(KEY_S)) { // Move backward
-            float newX = player.pos.x + backwardX * CELL_SIZE;
-            float newY = player.pos.y + backwardY * CELL_SIZE;
-            if (IsPointInMap(newX, newY) && map[(int)newY][(int)newX] != 'w') {
-                player.pos.x = newX;
-                player.pos.y = newY;
-            }
-        }
+    if (headless.pipelined) {
+        PipelineConfig config = {
+            .level = &level,
+            .viewCache = headless.viewCache != VIEW_CACHE_OFF ? &viewCache : NULL,
+            .atlas = &atlas,
+            .sprites = &sprites,
+            .pvsView = headless.pvs ? &pvsView : NULL,
+            .resolution = dynamic ? &resolution : NULL,
+            .pool = pool,
+            .viewDistance = headless.viewDistance,
+            .width = SCREEN_WIDTH,
+            .height = SCREEN_HEIGHT,
+        };
+        // Returns once the window is closing, which also skips the loop below
+        RunPipelinedWindow(&headless, &config, &player, fbTexture, showProfile, tracePath);
+    }
 
-        // Discrete 90-degree rotation
-        if (IsKeyPressed(KEY_A)) { // Turn left
-            player.angle += 90.0f;
-            if (player.angle >= 360.0f) player.angle -= 360.0f;
+    ThreadPoolPinCaller(pool);
+    while (!WindowShouldClose()) {
+        uint64_t frameZone = ProfileBegin();
+        uint64_t zone = ProfileBegin();
+        HandleProfileKeys(&showProfile, tracePath);
+        InputFrame input;
+        if (headless.replayPath) {
+            if (!InputLogRead(&inputLog, &input)) break; // End of the recorded session
+        } else {
+            input = PollInputFrame(inputFrame);
+            if (recordPath) InputLogWrite(&inputLog, &input);
         }
-        if (IsKeyPressed(KEY_D)) { // Turn right
-            player.angle -= 90.0f;
-            if (player.angle < 0.0f) player.angle += 360.0f;
+        inputFrame++;
+        if (IsKeyPressed(KEY_F)) useFramebuffer = !useFramebuffer;
+        ProfileEnd(PROFILE_INPUT, zone);
+
+        zone = ProfileBegin();
+        ApplyInputFrame(&input, turnRate, &level, &player, &showDebugMap, &textured, &caster);
+        ProfileEnd(PROFILE_MOVEMENT, zone);
+
+        // The window is one presenter over the backend-neutral hit buffer
+        double viewStart = GetMonotonicSeconds();
+        float scaleX = 1.0f, scaleY = 1.0f; // Of the frame drawn below
+        Framebuffer* view = dynamic ? DynamicResolutionBegin(&resolution, &fb) : &fb;
+        int numRays = GetViewRayCount(view->width, showDebugMap);
+        if (!RayTableEnsure(&rayTable, numRays, FOV)) goto done;
+        bool cached = headless.viewCache != VIEW_CACHE_OFF && view == &fb && ViewCacheMatchesCaster(caster) &&
+                      !textured && ViewCacheLookup(&viewCache, &player, showDebugMap, headless.viewDistance, hits);
+        // The floor and sprites are drawn at the heading the walls were cast at
+        Player viewer = player;
+        zone = ProfileBegin();
+        if (!cached && headless.temporal) {
+            viewer.angle =
+                TemporalCacheCast(&temporal, &level, &player, &rayTable, caster, headless.viewDistance, hits, pool);
+        } else if (!cached) {
+            CastView(&level, &player, &rayTable, caster, headless.viewDistance, hits, pool);
         }
+        ProfileEnd(PROFILE_CAST, zone);
 
         BeginDrawing();
         ClearBackground(BLACK);
 
-        // Raycasting with offset
-        int numRays = showDebugMap ? SCREEN_WIDTH / 2 : SCREEN_WIDTH;
-        float rayAngleStep = FOV / (float)numRays;
-
-        for (int i = 0; i < numRays; i++) {
-            float rayAngle = player.angle - (FOV / 2.0f) + (i * rayAngleStep);
-            float rayX = player.pos.x + PLAYER_OFFSET;
-            float rayY = player.pos.y + PLAYER_OFFSET;
-            float rayCos = cosf(rayAngle * DEG2RAD) / 32.0f;
-            float raySin = sinf(rayAngle * DEG2RAD) / 32.0f;
-            float distance = 0;
-            bool hitWall = false;
-
-            while (distance < 20) {
-                rayX += rayCos;
-                rayY += raySin;
-                distance = sqrtf(powf(rayX - (player.pos.x + PLAYER_OFFSET), 2) +
-                                 powf(rayY - (player.pos.y + PLAYER_OFFSET), 2));
-
-                if (!IsPointInMap(rayX, rayY)) {
-                    int columnX = showDebugMap ? SCREEN_WIDTH / 2 + i * 2 : i;
-                    DrawRectangle(columnX, 0, showDebugMap ? 2 : 1, SCREEN_HEIGHT, BLACK);
-                    hitWall = true;
-                    break;
-                }
-
-                if (map[(int)rayY][(int)rayX] == 'w') {
-                    float wallHeight = (SCREEN_HEIGHT / distance) * 2;
-                    int columnX = showDebugMap ? SCREEN_WIDTH / 2 + i * 2 : i;
-                    DrawRectangle(columnX, SCREEN_HEIGHT / 2 - wallHeight / 2, showDebugMap ? 2 : 1, wallHeight, BLUE);
-                    hitWall = true;
-                    break;
-                }
+        // Textured walls and sprites are only drawn on the CPU framebuffer
+        if (useFramebuffer || textured || sprites.count > 0 || dynamic) {
+            if (textured) {
+                if (showDebugMap) FramebufferClear(view, PIXEL_BLACK);
+                zone = ProfileBegin();
+                RenderFloorCeiling(view, &rayTable, &viewer, showDebugMap, &atlas, pool);
+                ProfileEnd(PROFILE_FLOOR, zone);
+                zone = ProfileBegin();
+                RenderViewTextured(view, hits, numRays, showDebugMap, map, &atlas);
+            } else {
+                zone = ProfileBegin();
+                FramebufferClear(view, PIXEL_BLACK);
+                RenderView(view, hits, numRays, showDebugMap);
             }
-
-            if (!hitWall && IsPointInMap(rayX, rayY)) {
-                int columnX = showDebugMap ? SCREEN_WIDTH / 2 + i * 2 : i;
-                DrawRectangle(columnX, 0, showDebugMap ? 2 : 1, SCREEN_HEIGHT, DARKGRAY);
+            ProfileEnd(PROFILE_WALLS, zone);
+            if (sprites.count > 0) {
+                zone = ProfileBegin();
+                if (headless.pvs) PvsViewSetCell(&pvsView, &level.pvs, (int)player.pos.x, (int)player.pos.y);
+                SpriteSetCollectVisible(&sprites, &viewer, &rayTable, hits, headless.pvs ? &pvsView : NULL);
+                RenderSprites(view, &sprites, &viewer, &rayTable, hits, showDebugMap);
+                ProfileEnd(PROFILE_SPRITES, zone);
             }
-        }
+            if (dynamic) {
+                scaleX = view == &fb ? 1.0f : resolution.scaleX;
+                scaleY = view == &fb ? 1.0f : resolution.scaleY;
+                DynamicResolutionUpdate(&resolution, (GetMonotonicSeconds() - viewStart) * 1000.0);
+                DynamicResolutionEnd(&resolution, &fb, showDebugMap);
+            }
+            if (showDebugMap) {
+                zone = ProfileBegin();
+                if (headless.pvs) PvsViewSetCell(&pvsView, &level.pvs, (int)player.pos.x, (int)player.pos.y);
+                RenderDebugMap(&fb, map, &player, headless.pvs ? &pvsView : NULL);
+                ProfileEnd(PROFILE_MINIMAP, zone);
+            }
+            zone = ProfileBegin();
+            UpdateTexture(fbTexture, fb.pixels);
+            DrawTexture(fbTexture, 0, 0, WHITE);
+            ProfileEnd(PROFILE_PRESENT, zone);
+        } else {
+            zone = ProfileBegin();
+            for (int i = 0; i < numRays; i++) {
+                int columnX = GetViewColumnX(SCREEN_WIDTH, showDebugMap, i);
+                int columnWidth = GetViewColumnWidth(showDebugMap);
+                if (hits[i].kind == RAY_HIT_WALL) {
+                    float wallHeight = (SCREEN_HEIGHT / hits[i].distance) * 2;
+                    DrawRectangle(columnX, SCREEN_HEIGHT / 2 - wallHeight / 2, columnWidth, wallHeight, BLUE);
+                } else if (hits[i].kind == RAY_HIT_OUTSIDE) {
+                    DrawRectangle(columnX, 0, columnWidth, SCREEN_HEIGHT, BLACK);
+                } else {
+                    DrawRectangle(columnX, 0, columnWidth, SCREEN_HEIGHT, DARKGRAY);
+                }
+            }
+            ProfileEnd(PROFILE_WALLS, zone);
 
-        if (showDebugMap) {
-            for (int y = 0; y < MAP_HEIGHT; y++) {
-                for (int x = 0; x < MAP_WIDTH; x++) {
-                    if (map[y][x] == 'w') {
-                        DrawRectangle(x * 32, y * 32, 32, 32, GRAY);
+            if (showDebugMap) {
+                zone = ProfileBegin();
+                MinimapWindow window = GetMinimapWindow(map, &player);
+                if (headless.pvs) PvsViewSetCell(&pvsView, &level.pvs, (int)player.pos.x, (int)player.pos.y);
+                for (int y = 0; y < window.rows; y++) {
+                    for (int x = 0; x < window.columns; x++) {
+                        int cellX = window.originX + x, cellY = window.originY + y;
+                        if (MapIsSolid(map, cellX, cellY) &&
+                            (!headless.pvs || PvsViewIsVisible(&pvsView, cellX, cellY))) {
+                            DrawRectangle(x * MINIMAP_CELL, y * MINIMAP_CELL, MINIMAP_CELL, MINIMAP_CELL, GRAY);
+                        }
                     }
                 }
+                float centerX = (player.pos.x - window.originX + PLAYER_OFFSET) * MINIMAP_CELL;
+                float centerY = (player.pos.y - window.originY + PLAYER_OFFSET) * MINIMAP_CELL;
+                DrawCircle(centerX, centerY, 5, RED);
+                DrawLine(centerX,
+                         centerY,
+                         centerX + cosf(player.angle * DEG2RAD) * 20,
+                         centerY + sinf(player.angle * DEG2RAD) * 20,
+                         RED);
+                ProfileEnd(PROFILE_MINIMAP, zone);
             }
-            DrawCircle((player.pos.x + PLAYER_OFFSET) * 32, (player.pos.y + PLAYER_OFFSET) * 32, 5, RED);
-            DrawLine((player.pos.x + PLAYER_OFFSET) * 32,
-                     (player.pos.y + PLAYER_OFFSET) * 32,
-                     (player.pos.x + PLAYER_OFFSET) * 32 + cosf(player.angle * DEG2RAD) * 20,
-                     (player.pos.y + PLAYER_OFFSET) * 32 + sinf(player.angle * DEG2RAD) * 20,
-                     RED);
         }
 
         DrawFPS(10, 10);
+        DrawText(TextFormat("%s%s", GetCasterName(caster),
+                            textured ? " / textured" : (useFramebuffer ? " / framebuffer" : "")),
+                 10, 30, 20, GREEN);
+        if (dynamic) DrawText(TextFormat("scale %.2f x %.2f", scaleX, scaleY), 10, 55, 20, GREEN);
+        if (showProfile) DrawProfileOverlay();
+        zone = ProfileBegin();
         EndDrawing();
+        ProfileEnd(PROFILE_PRESENT, zone);
+        ProfileEnd(PROFILE_FRAME, frameZone);
+        ProfileFrameMark();
     }
 
+    if (headless.viewCache != VIEW_CACHE_OFF) ViewCachePrintStats(&viewCache);
+    if (headless.temporal) TemporalCachePrintStats(&temporal);
+    if (recordPath) printf("input log: %u frames recorded to %s\n", inputLog.frames, recordPath);
+    status = 0;
+
+done:
+    if (inputLog.file && !InputLogClose(&inputLog)) {
+        fprintf(stderr, "input log: failed to close %s\n", recordPath ? recordPath : headless.replayPath);
+    }
+    if (fbTexture.id != 0) UnloadTexture(fbTexture);
+    ViewCacheFree(&viewCache);
+    TemporalCacheFree(&temporal);
+    ThreadPoolDestroy(pool);
+    RayTableFree(&rayTable);
+    DynamicResolutionFree(&resolution);
+    PvsViewFree(&pvsView);
+    SpriteSetFree(&sprites);
+    TextureAtlasFree(&atlas);
+    FramebufferFree(&fb);
+    LevelFree(&level);
     CloseWindow();
-    return 0;
+    return status;
 }
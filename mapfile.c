@@ -0,0 +1,232 @@
+#include "mapfile.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MAP_FILE_DATA_ALIGN 64
+#define MAP_FILE_MAX_SIZE ((uint32_t)INT_MAX - 2)
+
+static uint64_t AlignUp(uint64_t value, uint64_t align) {
+    return (value + align - 1) / align * align;
+}
+
+// The player starts in the spawn cell, so it must be inside the map and open
+static bool IsSpawnOpen(const Map* map) {
+    return map->spawnX >= 0 && map->spawnY >= 0 && map->spawnX < map->width && map->spawnY < map->height &&
+           !MapIsSolid(map, map->spawnX, map->spawnY);
+}
+
+// Casters step without bounds checks and rely on the border stopping them, so
+// the border rows, border columns and row padding must all be solid
+static bool HasSolidBorder(const Map* map) {
+    const uint64_t* bits = map->bits;
+    size_t lastRow = (size_t)(map->height + 1) * map->stride;
+    for (int word = 0; word < map->stride; word++) {
+        if (bits[word] != ~(uint64_t)0 || bits[lastRow + word] != ~(uint64_t)0) return false;
+    }
+    int padding = map->width + 1;
+    for (int y = 0; y < map->height; y++) {
+        const uint64_t* row = bits + (size_t)(y + 1) * map->stride;
+        if (!(row[0] & 1)) return false;
+        for (int word = padding >> 6; word < map->stride; word++) {
+            uint64_t mask = word == padding >> 6 ? ~(uint64_t)0 << (padding & 63) : ~(uint64_t)0;
+            if ((row[word] & mask) != mask) return false;
+        }
+    }
+    return true;
+}
+
+bool MapLoadBinary(Map* map, const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MapFileHeader)) {
+        close(fd);
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    const MapFileHeader* header = mapping;
+    uint64_t bitsSize = ((uint64_t)header->height + 2) * header->stride * sizeof(uint64_t);
+    uint64_t materialsSize = (uint64_t)header->width * header->height;
+    bool hasMaterials = header->flags & MAP_FILE_HAS_MATERIALS;
+    // Sizes stay in int with the border rows and columns added; offsets are checked without wrapping
+    bool bitsFit = header->bitsOffset % sizeof(uint64_t) == 0 && header->bitsOffset <= size &&
+                   size - header->bitsOffset >= bitsSize;
+    bool materialsFit = !hasMaterials ||
+                        (header->materialsOffset <= size && size - header->materialsOffset >= materialsSize);
+    bool valid = memcmp(header->magic, MAP_FILE_MAGIC, 4) == 0 && header->version == MAP_FILE_VERSION &&
+                 header->width > 0 && header->height > 0 && header->width <= MAP_FILE_MAX_SIZE &&
+                 header->height <= MAP_FILE_MAX_SIZE && header->stride == ((uint64_t)header->width + 2 + 63) / 64 &&
+                 header->spawnX <= INT_MAX && header->spawnY <= INT_MAX && bitsFit && materialsFit;
+    if (valid) {
+        *map = (Map){
+            .width = (int)header->width,
+            .height = (int)header->height,
+            .stride = (int)header->stride,
+            .bits = (uint64_t*)((char*)mapping + header->bitsOffset),
+            .materials = hasMaterials ? (uint8_t*)mapping + header->materialsOffset : NULL,
+            .spawnX = (int)header->spawnX,
+            .spawnY = (int)header->spawnY,
+            .mapping = mapping,
+            .mappingSize = size,
+        };
+        valid = HasSolidBorder(map) && IsSpawnOpen(map);
+    }
+    if (!valid) {
+        *map = (Map){0};
+        munmap(mapping, size);
+        return false;
+    }
+    return true;
+}
+
+bool MapSaveBinary(const Map* map, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+
+    uint64_t bitsSize = ((uint64_t)map->height + 2) * map->stride * sizeof(uint64_t);
+    MapFileHeader header = {
+        .magic = {'R', 'C', 'M', 'P'},
+        .version = MAP_FILE_VERSION,
+        .width = (uint32_t)map->width,
+        .height = (uint32_t)map->height,
+        .stride = (uint32_t)map->stride,
+        .flags = map->materials ? MAP_FILE_HAS_MATERIALS : 0,
+        .spawnX = (uint32_t)map->spawnX,
+        .spawnY = (uint32_t)map->spawnY,
+        .bitsOffset = AlignUp(sizeof(MapFileHeader), MAP_FILE_DATA_ALIGN),
+    };
+    header.materialsOffset = map->materials ? AlignUp(header.bitsOffset + bitsSize, MAP_FILE_DATA_ALIGN) : 0;
+
+    static const char padding[MAP_FILE_DATA_ALIGN] = {0};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(padding, 1, header.bitsOffset - sizeof(header), file) == header.bitsOffset - sizeof(header);
+    ok = ok && fwrite(map->bits, 1, bitsSize, file) == bitsSize;
+    if (map->materials) {
+        uint64_t gap = header.materialsOffset - (header.bitsOffset + bitsSize);
+        size_t count = (size_t)map->width * map->height;
+        ok = ok && fwrite(padding, 1, gap, file) == gap;
+        ok = ok && fwrite(map->materials, 1, count, file) == count;
+    }
+    return fclose(file) == 0 && ok;
+}
+
+static char* ReadWholeFile(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* data = length >= 0 ? malloc((size_t)length + 1) : NULL;
+    if (data && fread(data, 1, (size_t)length, file) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    if (data) {
+        data[length] = '\0';
+        *size = (size_t)length;
+    }
+    return data;
+}
+
+bool MapLoadText(Map* map, const char* path) {
+    size_t size;
+    char* text = ReadWholeFile(path, &size);
+    if (!text) return false;
+
+    // First pass: dimensions and whether any cell carries a material
+    int width = 0, height = 0, column = 0;
+    bool hasMaterials = false;
+    for (size_t i = 0; i < size; i++) {
+        if (text[i] == '\n') {
+            if (column > width) width = column;
+            height++;
+            column = 0;
+        } else if (text[i] != '\r') {
+            if (text[i] >= '1' && text[i] <= '9') hasMaterials = true;
+            column++;
+        }
+    }
+    if (column > 0) {
+        if (column > width) width = column;
+        height++;
+    }
+    if (width == 0 || !MapInit(map, width, height, hasMaterials)) {
+        free(text);
+        return false;
+    }
+
+    int x = 0, y = 0;
+    for (size_t i = 0; i < size; i++) {
+        char c = text[i];
+        if (c == '\n') {
+            x = 0;
+            y++;
+            continue;
+        }
+        if (c == '\r') continue;
+        if (c == 'w' || c == '#' || (c >= '1' && c <= '9')) {
+            MapSetSolid(map, x, y, true);
+            if (map->materials) map->materials[(size_t)y * width + x] = c >= '1' && c <= '9' ? (uint8_t)(c - '0') : 0;
+        } else if (c == 'P') {
+            map->spawnX = x;
+            map->spawnY = y;
+        }
+        x++;
+    }
+    free(text);
+    // Without a 'P' the spawn stays at MapInit's (1, 1), which may be a wall
+    if (!IsSpawnOpen(map)) {
+        MapFree(map);
+        return false;
+    }
+    return true;
+}
+
+bool MapSaveText(const Map* map, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+
+    char* row = malloc((size_t)map->width + 1);
+    if (!row) {
+        fclose(file);
+        return false;
+    }
+    bool ok = true;
+    for (int y = 0; y < map->height && ok; y++) {
+        for (int x = 0; x < map->width; x++) {
+            uint8_t material = MapGetMaterial(map, x, y);
+            if (MapIsSolid(map, x, y)) {
+                row[x] = material >= 1 && material <= 9 ? (char)('0' + material) : 'w';
+            } else {
+                row[x] = x == map->spawnX && y == map->spawnY ? 'P' : '0';
+            }
+        }
+        row[map->width] = '\n';
+        ok = fwrite(row, 1, (size_t)map->width + 1, file) == (size_t)map->width + 1;
+    }
+    free(row);
+    return fclose(file) == 0 && ok;
+}
+
+bool MapLoadFile(Map* map, const char* path) {
+    char magic[4] = {0};
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    size_t got = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+
+    if (got == sizeof(magic) && memcmp(magic, MAP_FILE_MAGIC, 4) == 0) return MapLoadBinary(map, path);
+    return MapLoadText(map, path);
+}
@@ -0,0 +1,37 @@
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+#include "world.h"
+
+// Binary map layout (little-endian). The occupancy words are stored exactly as
+// Map keeps them in memory, border included, so loading is a single mmap.
+#define MAP_FILE_MAGIC "RCMP"
+#define MAP_FILE_VERSION 1
+#define MAP_FILE_HAS_MATERIALS 1u
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride; // 64-bit words per padded row
+    uint32_t flags;
+    uint32_t spawnX;
+    uint32_t spawnY;
+    uint64_t bitsOffset; // (height + 2) * stride words
+    uint64_t materialsOffset; // width * height bytes when MAP_FILE_HAS_MATERIALS
+} MapFileHeader;
+
+// Zero-copy: bits and materials point into a private (copy-on-write) mapping
+bool MapLoadBinary(Map* map, const char* path);
+bool MapSaveBinary(const Map* map, const char* path);
+
+// Text maps: one row per line, 'w' or '#' = wall, '1'..'9' = wall with that
+// material, 'P' = spawn, anything else = empty
+bool MapLoadText(Map* map, const char* path);
+bool MapSaveText(const Map* map, const char* path);
+
+// Picks the binary or text loader from the file's magic
+bool MapLoadFile(Map* map, const char* path);
+
+#endif
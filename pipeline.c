@@ -0,0 +1,232 @@
+#include "pipeline.h"
+#include "clock.h"
+#include "floorcast.h"
+#include "profile.h"
+#include "render.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+// How often a composer waiting for the next tick checks for a stop
+#define PIPELINE_STOP_POLL_SECONDS 0.05
+
+typedef enum { FRAME_FREE, FRAME_COMPOSING, FRAME_READY, FRAME_PRESENTING } FrameState;
+
+struct RenderPipeline {
+    PipelineConfig config;
+    Simulation* sim;
+    Framebuffer frames[2];
+    SimSnapshot shown[2];
+    FrameState states[2];
+    unsigned serials[2]; // Order the frames were finished in
+    unsigned nextSerial;
+    float scaleX[2]; // Dynamic resolution scale each frame was drawn at
+    float scaleY[2];
+    float composedScaleX;
+    float composedScaleY;
+    RayTable rayTable;
+    RayHit* hits;
+    uint32_t editsApplied;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    atomic_bool stop; // Also read outside lock while waiting for a tick
+    pthread_t thread;
+};
+
+static void ComposeFrame(RenderPipeline* pipeline, const SimSnapshot* snapshot, Framebuffer* full) {
+    const PipelineConfig* config = &pipeline->config;
+    Level* level = config->level;
+    const Player* player = &snapshot->player;
+    bool showDebugMap = snapshot->showDebugMap;
+
+    for (; pipeline->editsApplied != snapshot->editCount; pipeline->editsApplied++) {
+        SimEdit edit = SimulationGetEdit(pipeline->sim, pipeline->editsApplied);
+        LevelSetSolid(level, edit.x, edit.y, edit.solid);
+    }
+    SimulationEditsApplied(pipeline->sim, pipeline->editsApplied);
+
+    CasterKind caster = PrepareCaster(level, snapshot->caster) ? snapshot->caster : CASTER_DDA;
+    bool textured = snapshot->textured && config->atlas;
+    DynamicResolution* resolution = config->resolution;
+    double start = GetMonotonicSeconds();
+    Framebuffer* fb = resolution ? DynamicResolutionBegin(resolution, full) : full;
+    bool scaled = resolution && resolution->active;
+    int numRays = GetViewRayCount(fb->width, showDebugMap);
+    if (!RayTableEnsure(&pipeline->rayTable, numRays, FOV)) return;
+
+    // Cached views keep no texture coordinates and hold full-width views only
+    bool cached = config->viewCache && !scaled && ViewCacheMatchesCaster(caster) && !textured &&
+                  ViewCacheLookup(config->viewCache, player, showDebugMap, config->viewDistance, pipeline->hits);
+    uint64_t zone = ProfileBegin();
+    if (!cached) {
+        CastView(level, player, &pipeline->rayTable, caster, config->viewDistance, pipeline->hits, config->pool);
+    }
+    ProfileEnd(PROFILE_CAST, zone);
+
+    if (textured) {
+        if (showDebugMap) FramebufferClear(fb, PIXEL_BLACK);
+        zone = ProfileBegin();
+        RenderFloorCeiling(fb, &pipeline->rayTable, player, showDebugMap, config->atlas, config->pool);
+        ProfileEnd(PROFILE_FLOOR, zone);
+        zone = ProfileBegin();
+        RenderViewTextured(fb, pipeline->hits, numRays, showDebugMap, &level->map, config->atlas);
+    } else {
+        zone = ProfileBegin();
+        FramebufferClear(fb, PIXEL_BLACK);
+        RenderView(fb, pipeline->hits, numRays, showDebugMap);
+    }
+    ProfileEnd(PROFILE_WALLS, zone);
+    if (config->sprites && config->sprites->count > 0) {
+        zone = ProfileBegin();
+        if (config->pvsView) PvsViewSetCell(config->pvsView, &level->pvs, (int)player->pos.x, (int)player->pos.y);
+        SpriteSetCollectVisible(config->sprites, player, &pipeline->rayTable, pipeline->hits, config->pvsView);
+        RenderSprites(fb, config->sprites, player, &pipeline->rayTable, pipeline->hits, showDebugMap);
+        ProfileEnd(PROFILE_SPRITES, zone);
+    }
+    pipeline->composedScaleX = scaled ? resolution->scaleX : 1.0f;
+    pipeline->composedScaleY = scaled ? resolution->scaleY : 1.0f;
+    if (resolution) {
+        DynamicResolutionUpdate(resolution, (GetMonotonicSeconds() - start) * 1000.0);
+        DynamicResolutionEnd(resolution, full, showDebugMap);
+    }
+    if (showDebugMap) {
+        zone = ProfileBegin();
+        if (config->pvsView) PvsViewSetCell(config->pvsView, &level->pvs, (int)player->pos.x, (int)player->pos.y);
+        RenderDebugMap(full, &level->map, player, config->pvsView);
+        ProfileEnd(PROFILE_MINIMAP, zone);
+    }
+}
+
+// Picks a free frame, or the older of two ready ones when the caller is slow
+static int PickTarget(const RenderPipeline* pipeline) {
+    int target = -1;
+    for (int i = 0; i < 2; i++) {
+        if (pipeline->states[i] == FRAME_FREE) return i;
+        if (pipeline->states[i] == FRAME_READY && (target < 0 || pipeline->serials[i] < pipeline->serials[target])) {
+            target = i;
+        }
+    }
+    return target >= 0 && pipeline->states[1 - target] == FRAME_READY ? target : -1;
+}
+
+static void* PipelineMain(void* arg) {
+    RenderPipeline* pipeline = arg;
+    // This thread runs the pool's jobs here, not the one that created the pool
+    ThreadPoolPinCaller(pipeline->config.pool);
+    uint32_t composedTick = 0;
+    bool composedAny = false;
+    pthread_mutex_lock(&pipeline->lock);
+    for (;;) {
+        int target = -1;
+        while (!pipeline->stop && (target = PickTarget(pipeline)) < 0) {
+            pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+        }
+        if (pipeline->stop) break;
+        pipeline->states[target] = FRAME_COMPOSING;
+        pthread_mutex_unlock(&pipeline->lock);
+
+        // Snapshots and edits only change on a tick, so the same tick is never composed twice
+        SimSnapshot snapshot;
+        SimulationGetSnapshot(pipeline->sim, &snapshot);
+        while (composedAny && snapshot.tick == composedTick && !atomic_load(&pipeline->stop)) {
+            SimulationWaitForTick(pipeline->sim, composedTick, PIPELINE_STOP_POLL_SECONDS);
+            SimulationGetSnapshot(pipeline->sim, &snapshot);
+        }
+        if (atomic_load(&pipeline->stop)) {
+            pthread_mutex_lock(&pipeline->lock);
+            pipeline->states[target] = FRAME_FREE;
+            break;
+        }
+        ComposeFrame(pipeline, &snapshot, &pipeline->frames[target]);
+        composedTick = snapshot.tick;
+        composedAny = true;
+
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->shown[target] = snapshot;
+        pipeline->scaleX[target] = pipeline->composedScaleX;
+        pipeline->scaleY[target] = pipeline->composedScaleY;
+        pipeline->states[target] = FRAME_READY;
+        pipeline->serials[target] = ++pipeline->nextSerial;
+        pthread_cond_broadcast(&pipeline->changed);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+    return NULL;
+}
+
+RenderPipeline* RenderPipelineStart(const PipelineConfig* config, Simulation* sim) {
+    RenderPipeline* pipeline = calloc(1, sizeof(RenderPipeline));
+    if (!pipeline) return NULL;
+    pipeline->config = *config;
+    pipeline->sim = sim;
+    pipeline->hits = malloc(sizeof(RayHit) * config->width);
+    bool ok = pipeline->hits && FramebufferInit(&pipeline->frames[0], config->width, config->height) &&
+              FramebufferInit(&pipeline->frames[1], config->width, config->height);
+    pthread_mutex_init(&pipeline->lock, NULL);
+    pthread_cond_init(&pipeline->changed, NULL);
+    if (ok && pthread_create(&pipeline->thread, NULL, PipelineMain, pipeline) == 0) return pipeline;
+
+    FramebufferFree(&pipeline->frames[0]);
+    FramebufferFree(&pipeline->frames[1]);
+    pthread_cond_destroy(&pipeline->changed);
+    pthread_mutex_destroy(&pipeline->lock);
+    free(pipeline->hits);
+    free(pipeline);
+    return NULL;
+}
+
+void RenderPipelineStop(RenderPipeline* pipeline) {
+    if (!pipeline) return;
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->stop = true;
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->lock);
+    pthread_join(pipeline->thread, NULL);
+
+    FramebufferFree(&pipeline->frames[0]);
+    FramebufferFree(&pipeline->frames[1]);
+    RayTableFree(&pipeline->rayTable);
+    pthread_cond_destroy(&pipeline->changed);
+    pthread_mutex_destroy(&pipeline->lock);
+    free(pipeline->hits);
+    free(pipeline);
+}
+
+const Framebuffer* RenderPipelineAcquire(RenderPipeline* pipeline, SimSnapshot* snapshot) {
+    pthread_mutex_lock(&pipeline->lock);
+    int frame = -1;
+    while (frame < 0) {
+        for (int i = 0; i < 2; i++) {
+            if (pipeline->states[i] == FRAME_READY && (frame < 0 || pipeline->serials[i] > pipeline->serials[frame])) {
+                frame = i;
+            }
+        }
+        if (frame < 0) pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+    }
+    // An older ready frame is never shown now
+    if (pipeline->states[1 - frame] == FRAME_READY) pipeline->states[1 - frame] = FRAME_FREE;
+    pipeline->states[frame] = FRAME_PRESENTING;
+    *snapshot = pipeline->shown[frame];
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->lock);
+    return &pipeline->frames[frame];
+}
+
+void RenderPipelineRelease(RenderPipeline* pipeline) {
+    pthread_mutex_lock(&pipeline->lock);
+    for (int i = 0; i < 2; i++) {
+        if (pipeline->states[i] == FRAME_PRESENTING) pipeline->states[i] = FRAME_FREE;
+    }
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->lock);
+}
+
+void RenderPipelineGetScale(RenderPipeline* pipeline, float* scaleX, float* scaleY) {
+    pthread_mutex_lock(&pipeline->lock);
+    *scaleX = *scaleY = 1.0f;
+    for (int i = 0; i < 2; i++) {
+        if (pipeline->states[i] == FRAME_PRESENTING) {
+            *scaleX = pipeline->scaleX[i];
+            *scaleY = pipeline->scaleY[i];
+        }
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+}
@@ -0,0 +1,39 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "dynres.h"
+#include "framebuffer.h"
+#include "sim.h"
+#include "sprite.h"
+#include "texture.h"
+#include "viewcache.h"
+
+// Casts and composes frames on a worker thread from the latest simulation
+// snapshot, into two framebuffers: frame N + 1 is drawn while the caller
+// presents frame N. The worker owns everything in the config while it runs
+// and patches the level with the simulation's edits itself.
+typedef struct {
+    Level* level;
+    ViewCache* viewCache; // NULL = off
+    const TextureAtlas* atlas; // Needed for textured snapshots
+    SpriteSet* sprites; // NULL or empty = none
+    PvsView* pvsView; // NULL = every cell on the minimap
+    DynamicResolution* resolution; // NULL = always full resolution
+    ThreadPool* pool;
+    float viewDistance;
+    int width;
+    int height;
+} PipelineConfig;
+
+typedef struct RenderPipeline RenderPipeline;
+
+RenderPipeline* RenderPipelineStart(const PipelineConfig* config, Simulation* sim);
+void RenderPipelineStop(RenderPipeline* pipeline);
+// Blocks until a frame newer than the last acquired one is ready and returns
+// it with the snapshot it shows. It stays untouched until released.
+const Framebuffer* RenderPipelineAcquire(RenderPipeline* pipeline, SimSnapshot* snapshot);
+void RenderPipelineRelease(RenderPipeline* pipeline);
+// Dynamic resolution scale of the acquired frame; 1 without a controller
+void RenderPipelineGetScale(RenderPipeline* pipeline, float* scaleX, float* scaleY);
+
+#endif
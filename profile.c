@@ -0,0 +1,173 @@
+#include "profile.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+    uint64_t begin; // Nanoseconds since profileEpoch
+    uint64_t end;
+    uint32_t frame;
+    uint32_t stage;
+} ProfileEvent;
+
+// Written only by its owning thread. head counts every event ever written, so
+// slot head & mask holds event head - PROFILE_RING_SIZE until it is replaced.
+typedef struct {
+    _Atomic uint64_t head;
+    ProfileEvent events[PROFILE_RING_SIZE];
+} ProfileRing;
+
+static const char* stageNames[PROFILE_STAGE_COUNT] = {
+    "frame", "input", "movement", "cast", "cast chunk", "floor", "floor rows", "walls", "sprites", "minimap", "present",
+};
+
+static atomic_bool profileEnabled;
+static _Atomic uint32_t profileFrame;
+static uint64_t profileEpoch;
+static ProfileRing* _Atomic rings[PROFILE_MAX_THREADS];
+static atomic_int ringCount;
+static _Thread_local ProfileRing* threadRing;
+static _Thread_local bool threadRingFailed;
+
+// Reader scratch, reused between calls
+static ProfileEvent* snapshot;
+
+static uint64_t GetNanoseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void ProfileSetEnabled(bool enabled) {
+    if (enabled && profileEpoch == 0) profileEpoch = GetNanoseconds() - 1;
+    atomic_store(&profileEnabled, enabled);
+}
+
+bool ProfileIsEnabled(void) {
+    return atomic_load_explicit(&profileEnabled, memory_order_relaxed);
+}
+
+const char* GetProfileStageName(ProfileStage stage) {
+    return stage < PROFILE_STAGE_COUNT ? stageNames[stage] : "unknown";
+}
+
+uint64_t ProfileBegin(void) {
+    if (!atomic_load_explicit(&profileEnabled, memory_order_relaxed)) return 0;
+    return GetNanoseconds() - profileEpoch;
+}
+
+// A thread claims a ring slot the first time it records; slots are never
+// released, so a ring outlives its thread and stays readable
+static ProfileRing* GetThreadRing(void) {
+    if (threadRing || threadRingFailed) return threadRing;
+    int slot = atomic_fetch_add(&ringCount, 1);
+    ProfileRing* ring = slot < PROFILE_MAX_THREADS ? calloc(1, sizeof(ProfileRing)) : NULL;
+    if (!ring) {
+        threadRingFailed = true;
+        return NULL;
+    }
+    atomic_store_explicit(&rings[slot], ring, memory_order_release);
+    threadRing = ring;
+    return ring;
+}
+
+void ProfileEnd(ProfileStage stage, uint64_t begin) {
+    if (begin == 0) return;
+    ProfileRing* ring = GetThreadRing();
+    if (!ring) return;
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    ProfileEvent* event = &ring->events[head & (PROFILE_RING_SIZE - 1)];
+    event->begin = begin;
+    event->end = GetNanoseconds() - profileEpoch;
+    event->frame = atomic_load_explicit(&profileFrame, memory_order_relaxed);
+    event->stage = stage;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void ProfileFrameMark(void) {
+    atomic_fetch_add_explicit(&profileFrame, 1, memory_order_relaxed);
+}
+
+// Copies the live events of one ring into snapshot and returns how many are
+// valid. Events the writer may have overwritten during the copy are dropped,
+// seqlock style, by re-reading head afterwards.
+static int SnapshotRing(ProfileRing* ring) {
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint64_t first = head > PROFILE_RING_SIZE ? head - PROFILE_RING_SIZE : 0;
+    for (uint64_t i = first; i < head; i++) snapshot[i - first] = ring->events[i & (PROFILE_RING_SIZE - 1)];
+    atomic_thread_fence(memory_order_acquire);
+    uint64_t after = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    // While event `after` is being written, slot after - RING_SIZE is already gone
+    uint64_t safe = after >= PROFILE_RING_SIZE ? after - PROFILE_RING_SIZE + 1 : 0;
+    if (safe <= first) return (int)(head - first);
+    if (safe >= head) return 0;
+    int dropped = (int)(safe - first);
+    for (uint64_t i = safe; i < head; i++) snapshot[i - safe] = snapshot[i - first];
+    return (int)(head - first) - dropped;
+}
+
+static bool EnsureSnapshot(void) {
+    if (!snapshot) snapshot = malloc(sizeof(ProfileEvent) * PROFILE_RING_SIZE);
+    return snapshot != NULL;
+}
+
+static int GetRingCount(void) {
+    int count = atomic_load(&ringCount);
+    return count < PROFILE_MAX_THREADS ? count : PROFILE_MAX_THREADS;
+}
+
+void ProfileSummarize(int frames, ProfileSummary* summary) {
+    *summary = (ProfileSummary){0};
+    uint32_t current = atomic_load(&profileFrame);
+    if (frames > (int)current) frames = (int)current;
+    if (frames <= 0 || !EnsureSnapshot()) return;
+
+    // Only whole frames: the one still being recorded is left out
+    uint32_t oldest = current - (uint32_t)frames;
+    for (int r = 0; r < GetRingCount(); r++) {
+        ProfileRing* ring = atomic_load_explicit(&rings[r], memory_order_acquire);
+        if (!ring) continue;
+        int count = SnapshotRing(ring);
+        bool recorded = false;
+        for (int i = 0; i < count; i++) {
+            const ProfileEvent* event = &snapshot[i];
+            if (event->frame < oldest || event->frame >= current) continue;
+            summary->stageMs[event->stage] += (event->end - event->begin) * 1e-6;
+            recorded = true;
+        }
+        if (recorded) summary->threads++;
+    }
+    summary->frames = frames;
+    for (int s = 0; s < PROFILE_STAGE_COUNT; s++) summary->stageMs[s] /= frames;
+}
+
+// Complete ("X") events in microseconds, one trace thread per ring
+bool ProfileWriteTrace(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file || !EnsureSnapshot()) {
+        if (file) fclose(file);
+        return false;
+    }
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+    for (int r = 0; r < GetRingCount(); r++) {
+        ProfileRing* ring = atomic_load_explicit(&rings[r], memory_order_acquire);
+        if (!ring) continue;
+        fprintf(file, "%s  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                      "\"args\": {\"name\": \"thread %d\"}}",
+                first ? "" : ",\n", r, r);
+        first = false;
+        int count = SnapshotRing(ring);
+        for (int i = 0; i < count; i++) {
+            const ProfileEvent* event = &snapshot[i];
+            fprintf(file, ",\n  {\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, "
+                          "\"dur\": %.3f, \"args\": {\"frame\": %u}}",
+                    stageNames[event->stage], r, event->begin * 1e-3, (event->end - event->begin) * 1e-3,
+                    event->frame);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
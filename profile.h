@@ -0,0 +1,49 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Stage timers. Each thread records into its own ring of the most recent
+// PROFILE_RING_SIZE events with no locks; one reader thread summarises the
+// rings for the overlay or writes them out as a Chrome trace_event file.
+#define PROFILE_RING_SIZE 4096 // Power of two
+#define PROFILE_MAX_THREADS 64
+#define PROFILE_SUMMARY_FRAMES 120 // Frames the overlay and reports average over
+
+typedef enum {
+    PROFILE_FRAME,
+    PROFILE_INPUT,
+    PROFILE_MOVEMENT,
+    PROFILE_CAST,
+    PROFILE_CAST_CHUNK, // One pool chunk of rays, on whichever thread ran it
+    PROFILE_FLOOR,
+    PROFILE_FLOOR_ROWS, // One pool chunk of floor rows
+    PROFILE_WALLS,
+    PROFILE_SPRITES,
+    PROFILE_MINIMAP,
+    PROFILE_PRESENT,
+    PROFILE_STAGE_COUNT
+} ProfileStage;
+
+typedef struct {
+    int frames; // Complete frames covered
+    int threads; // Threads that recorded anything
+    double stageMs[PROFILE_STAGE_COUNT]; // Per-frame average, summed over threads
+} ProfileSummary;
+
+void ProfileSetEnabled(bool enabled);
+bool ProfileIsEnabled(void);
+const char* GetProfileStageName(ProfileStage stage);
+
+// Returns 0 while disabled, which ProfileEnd then ignores
+uint64_t ProfileBegin(void);
+void ProfileEnd(ProfileStage stage, uint64_t begin);
+// Closes the current frame; events are tagged with the frame they end in
+void ProfileFrameMark(void);
+
+// Reader side: call from one thread at a time
+void ProfileSummarize(int frames, ProfileSummary* summary);
+bool ProfileWriteTrace(const char* path);
+
+#endif
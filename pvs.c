@@ -0,0 +1,636 @@
+#include "pvs.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PVS_VISIBLE 1
+
+typedef struct {
+    const Map* map;
+    int radius;
+    uint8_t** rowData; // Encoded sets of one map row, back to back
+    size_t* rowSize;
+    bool failed;
+} PvsBuildJob;
+
+// Quadrant coordinates: the source cell is [0, 1]^2 and cell (x, y) is
+// [x, x + 1] x [y, y + 1], x and y counted away from the source
+typedef struct {
+    int xi;
+    int yi;
+    int xf;
+    int yf;
+} PvsLine;
+
+// A blocker corner a view line was bent around; bumps form chains through parent
+typedef struct {
+    int x;
+    int y;
+    int parent; // -1 ends the chain
+} PvsBump;
+
+// A wedge of sight still open, between its shallow and steep lines
+typedef struct {
+    PvsLine shallow;
+    PvsLine steep;
+    int shallowBump;
+    int steepBump;
+} PvsSight;
+
+// Working memory for computing one set, reused from cell to cell
+typedef struct {
+    int radius;
+    uint8_t* state; // (2r + 1)^2 window around the cell, PVS_VISIBLE or 0
+    uint8_t* entry; // The set encoded
+    PvsSight* sights; // Ordered shallow to steep
+    int sightCount;
+    PvsBump* bumps;
+    int bumpCount;
+} PvsScratch;
+
+static size_t WriteVarint(uint8_t* out, uint32_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (uint8_t)value;
+    return length;
+}
+
+static uint32_t ReadVarint(const uint8_t** in) {
+    uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t byte = *(*in)++;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+}
+
+// ReadVarint for untrusted data: fails past end or after the 5 bytes a uint32_t takes
+static bool ReadVarintChecked(const uint8_t** in, const uint8_t* end, uint32_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*in == end) return false;
+        uint8_t byte = *(*in)++;
+        if (shift == 28 && byte > 0x0F) return false;
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Whether a loaded set decodes inside the data and its runs stay inside its window
+static bool CheckEntry(const uint8_t* data, size_t dataSize, uint32_t offset, int radius) {
+    const uint8_t* in = data + offset;
+    const uint8_t* end = data + dataSize;
+    uint64_t cells = (uint64_t)(2 * radius + 1) * (2 * radius + 1);
+    uint32_t runs, length;
+    if (!ReadVarintChecked(&in, end, &runs) || runs > cells + 1) return false;
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < runs; i++) {
+        if (!ReadVarintChecked(&in, end, &length)) return false;
+        total += length;
+        if (total > cells) return false;
+    }
+    return true;
+}
+
+static size_t GetEntrySize(const uint8_t* entry) {
+    const uint8_t* in = entry;
+    uint32_t runs = ReadVarint(&in);
+    for (uint32_t i = 0; i < runs; i++) ReadVarint(&in);
+    return (size_t)(in - entry);
+}
+
+// Positive below the line, negative above, in the quadrant's frame
+static int RelativeSlope(const PvsLine* line, int x, int y) {
+    return (line->yf - line->yi) * (line->xf - x) - (line->xf - line->xi) * (line->yf - y);
+}
+
+static void AddShallowBump(PvsScratch* scratch, PvsSight* sight, int x, int y) {
+    sight->shallow.xf = x;
+    sight->shallow.yf = y;
+    scratch->bumps[scratch->bumpCount] = (PvsBump){x, y, sight->shallowBump};
+    sight->shallowBump = scratch->bumpCount++;
+    for (int b = sight->steepBump; b >= 0; b = scratch->bumps[b].parent) {
+        if (RelativeSlope(&sight->shallow, scratch->bumps[b].x, scratch->bumps[b].y) < 0) {
+            sight->shallow.xi = scratch->bumps[b].x;
+            sight->shallow.yi = scratch->bumps[b].y;
+        }
+    }
+}
+
+static void AddSteepBump(PvsScratch* scratch, PvsSight* sight, int x, int y) {
+    sight->steep.xf = x;
+    sight->steep.yf = y;
+    scratch->bumps[scratch->bumpCount] = (PvsBump){x, y, sight->steepBump};
+    sight->steepBump = scratch->bumpCount++;
+    for (int b = sight->shallowBump; b >= 0; b = scratch->bumps[b].parent) {
+        if (RelativeSlope(&sight->steep, scratch->bumps[b].x, scratch->bumps[b].y) > 0) {
+            sight->steep.xi = scratch->bumps[b].x;
+            sight->steep.yi = scratch->bumps[b].y;
+        }
+    }
+}
+
+static void RemoveSight(PvsScratch* scratch, int index) {
+    memmove(&scratch->sights[index], &scratch->sights[index + 1],
+            sizeof(PvsSight) * (size_t)(scratch->sightCount - index - 1));
+    scratch->sightCount--;
+}
+
+// Drops a sight that has closed into a single line through a corner of the source
+static bool CheckSight(PvsScratch* scratch, int index) {
+    const PvsSight* sight = &scratch->sights[index];
+    bool collinear = RelativeSlope(&sight->shallow, sight->steep.xi, sight->steep.yi) == 0 &&
+                     RelativeSlope(&sight->shallow, sight->steep.xf, sight->steep.yf) == 0;
+    if (collinear &&
+        (RelativeSlope(&sight->shallow, 0, 1) == 0 || RelativeSlope(&sight->shallow, 1, 0) == 0)) {
+        RemoveSight(scratch, index);
+        return false;
+    }
+    return true;
+}
+
+// Precise permissive field of view over one quadrant: cells are visited in
+// diagonals moving away from the source, and each wall narrows, splits or
+// closes the sight it sits in.
+static void ScanQuadrant(const Map* map, int fromX, int fromY, int signX, int signY, PvsScratch* scratch) {
+    int radius = scratch->radius;
+    int size = 2 * radius + 1;
+    int extentX = signX > 0 ? map->width - 1 - fromX : fromX;
+    int extentY = signY > 0 ? map->height - 1 - fromY : fromY;
+    if (extentX > radius) extentX = radius;
+    if (extentY > radius) extentY = radius;
+    scratch->sights[0] = (PvsSight){{0, 1, radius, 0}, {1, 0, 0, radius}, -1, -1};
+    scratch->sightCount = 1;
+    scratch->bumpCount = 0;
+
+    for (int i = 1; i <= extentX + extentY && scratch->sightCount > 0; i++) {
+        int index = 0; // Cells along a diagonal only get steeper
+        int lastJ = i < extentY ? i : extentY;
+        for (int j = i > extentX ? i - extentX : 0; j <= lastJ && index < scratch->sightCount; j++) {
+            int x = i - j, y = j;
+            while (index < scratch->sightCount && RelativeSlope(&scratch->sights[index].steep, x + 1, y) >= 0) {
+                index++;
+            }
+            if (index == scratch->sightCount || RelativeSlope(&scratch->sights[index].shallow, x, y + 1) <= 0) {
+                continue;
+            }
+            scratch->state[(y * signY + radius) * size + x * signX + radius] = PVS_VISIBLE;
+            if (!MapIsSolid(map, fromX + x * signX, fromY + y * signY)) continue;
+
+            PvsSight* sight = &scratch->sights[index];
+            bool shallowCrosses = RelativeSlope(&sight->shallow, x + 1, y) < 0;
+            bool steepCrosses = RelativeSlope(&sight->steep, x, y + 1) > 0;
+            if (shallowCrosses && steepCrosses) {
+                RemoveSight(scratch, index);
+            } else if (shallowCrosses) {
+                AddShallowBump(scratch, sight, x, y + 1);
+                CheckSight(scratch, index);
+            } else if (steepCrosses) {
+                AddSteepBump(scratch, sight, x + 1, y);
+                CheckSight(scratch, index);
+            } else {
+                // The wall sits inside the sight: the part below it and the part above go on separately
+                memmove(&scratch->sights[index + 1], &scratch->sights[index],
+                        sizeof(PvsSight) * (size_t)(scratch->sightCount - index));
+                scratch->sightCount++;
+                int steepIndex = index + 1;
+                AddSteepBump(scratch, &scratch->sights[index], x + 1, y);
+                if (!CheckSight(scratch, index)) steepIndex--;
+                AddShallowBump(scratch, &scratch->sights[steepIndex], x, y + 1);
+                CheckSight(scratch, steepIndex);
+            }
+        }
+    }
+}
+
+// A cell is in the set when some line from a point of the source cell reaches
+// a point of it without passing through the inside of a wall, so the set
+// never leaves out a cell that can be seen. Leaves PVS_VISIBLE for those in
+// scratch->state.
+static void ComputeCellSet(const Map* map, int fromX, int fromY, PvsScratch* scratch) {
+    int size = 2 * scratch->radius + 1;
+    memset(scratch->state, 0, (size_t)size * size);
+    scratch->state[scratch->radius * size + scratch->radius] = PVS_VISIBLE;
+    ScanQuadrant(map, fromX, fromY, 1, 1, scratch);
+    ScanQuadrant(map, fromX, fromY, 1, -1, scratch);
+    ScanQuadrant(map, fromX, fromY, -1, -1, scratch);
+    ScanQuadrant(map, fromX, fromY, -1, 1, scratch);
+}
+
+// Run-length encodes the visible cells of the window, returns the byte count.
+// The run count comes first, so the runs are counted before they are written.
+static size_t EncodeCellSet(const uint8_t* state, int radius, uint8_t* out) {
+    int cells = (2 * radius + 1) * (2 * radius + 1);
+    uint32_t runCount = 0;
+    uint8_t current = 0; // Runs start with a hidden one, which may be empty
+    for (int i = 0; i < cells; i++) {
+        uint8_t visible = state[i] == PVS_VISIBLE;
+        runCount += visible != current;
+        current = visible;
+    }
+    // A trailing hidden run is implied
+    runCount += current;
+
+    size_t size = WriteVarint(out, runCount);
+    uint32_t length = 0;
+    current = 0;
+    for (int i = 0; i < cells; i++) {
+        uint8_t visible = state[i] == PVS_VISIBLE;
+        if (visible != current) {
+            size += WriteVarint(out + size, length);
+            length = 0;
+            current = visible;
+        }
+        length++;
+    }
+    if (current) size += WriteVarint(out + size, length);
+    return size;
+}
+
+static size_t GetMaxEntrySize(int radius) {
+    size_t cells = (size_t)(2 * radius + 1) * (2 * radius + 1);
+    return (cells + 2) * 5;
+}
+
+static void PvsScratchFree(PvsScratch* scratch) {
+    free(scratch->state);
+    free(scratch->entry);
+    free(scratch->sights);
+    free(scratch->bumps);
+    *scratch = (PvsScratch){0};
+}
+
+// A quadrant holds (r + 1)^2 cells; each wall in it adds at most one sight and two bumps
+static bool PvsScratchInit(PvsScratch* scratch, int radius) {
+    size_t size = 2 * (size_t)radius + 1;
+    size_t quadrant = ((size_t)radius + 1) * (radius + 1);
+    *scratch = (PvsScratch){
+        .radius = radius,
+        .state = malloc(size * size),
+        .entry = malloc(GetMaxEntrySize(radius)),
+        .sights = malloc(sizeof(PvsSight) * (quadrant + 1)),
+        .bumps = malloc(sizeof(PvsBump) * quadrant * 2),
+    };
+    if (scratch->state && scratch->entry && scratch->sights && scratch->bumps) return true;
+    PvsScratchFree(scratch);
+    return false;
+}
+
+static void BuildRows(void* context, int begin, int end) {
+    PvsBuildJob* job = context;
+    const Map* map = job->map;
+    PvsScratch scratch;
+    if (!PvsScratchInit(&scratch, job->radius)) {
+        job->failed = true;
+        return;
+    }
+
+    for (int y = begin; y < end; y++) {
+        size_t capacity = 256, used = 0;
+        uint8_t* row = malloc(capacity);
+        for (int x = 0; x < map->width && row; x++) {
+            if (MapIsSolid(map, x, y)) continue;
+            ComputeCellSet(map, x, y, &scratch);
+            size_t length = EncodeCellSet(scratch.state, job->radius, scratch.entry);
+            if (used + length > capacity) {
+                while (used + length > capacity) capacity *= 2;
+                uint8_t* grown = realloc(row, capacity);
+                if (!grown) {
+                    free(row);
+                    row = NULL;
+                    break;
+                }
+                row = grown;
+            }
+            memcpy(row + used, scratch.entry, length);
+            used += length;
+        }
+        if (!row) job->failed = true;
+        job->rowData[y] = row;
+        job->rowSize[y] = used;
+    }
+    PvsScratchFree(&scratch);
+}
+
+bool PvsBuild(Pvs* pvs, const Map* map, int radius, ThreadPool* pool) {
+    *pvs = (Pvs){.map = map, .width = map->width, .height = map->height, .radius = radius};
+    if (radius <= 0 || radius > PVS_MAX_RADIUS) return false;
+    PvsBuildJob job = {
+        .map = map,
+        .radius = radius,
+        .rowData = calloc(map->height, sizeof(uint8_t*)),
+        .rowSize = calloc(map->height, sizeof(size_t)),
+    };
+    pvs->offsets = malloc(sizeof(uint32_t) * map->width * map->height);
+    pvs->syncedEdits = calloc((size_t)map->width * map->height, sizeof(uint32_t));
+    pvs->stale = calloc((size_t)map->width * map->height, 1);
+    bool ok = job.rowData && job.rowSize && pvs->offsets && pvs->syncedEdits && pvs->stale;
+    if (ok) ThreadPoolRun(pool, BuildRows, &job, map->height);
+    ok = ok && !job.failed;
+
+    size_t total = 0;
+    for (int y = 0; ok && y < map->height; y++) total += job.rowSize[y];
+    if (ok && total >= PVS_NO_ENTRY) ok = false;
+    if (ok) {
+        pvs->data = malloc(total > 0 ? total : 1);
+        pvs->dataCapacity = total;
+        ok = pvs->data != NULL;
+    }
+    for (int y = 0; ok && y < map->height; y++) {
+        const uint8_t* in = job.rowData[y];
+        for (int x = 0; x < map->width; x++) {
+            if (MapIsSolid(map, x, y)) {
+                pvs->offsets[y * map->width + x] = PVS_NO_ENTRY;
+                continue;
+            }
+            size_t length = GetEntrySize(in);
+            pvs->offsets[y * map->width + x] = (uint32_t)pvs->dataSize;
+            memcpy(pvs->data + pvs->dataSize, in, length);
+            pvs->dataSize += length;
+            in += length;
+        }
+    }
+
+    for (int y = 0; job.rowData && y < map->height; y++) free(job.rowData[y]);
+    free(job.rowData);
+    free(job.rowSize);
+    if (!ok) PvsFree(pvs);
+    return ok;
+}
+
+void PvsFree(Pvs* pvs) {
+    free(pvs->offsets);
+    free(pvs->data);
+    free(pvs->syncedEdits);
+    free(pvs->stale);
+    *pvs = (Pvs){0};
+}
+
+bool PvsLoad(Pvs* pvs, const Map* map, const char* path) {
+    *pvs = (Pvs){0};
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    PvsFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, PVS_FILE_MAGIC, 4) == 0 &&
+              header.version == PVS_FILE_VERSION && header.width == (uint32_t)map->width &&
+              header.height == (uint32_t)map->height && header.radius > 0 && header.radius <= PVS_MAX_RADIUS &&
+              header.dataSize < PVS_NO_ENTRY && header.mapHash == MapHashBits(map);
+    if (ok) {
+        size_t cells = (size_t)map->width * map->height;
+        *pvs = (Pvs){
+            .map = map,
+            .width = map->width,
+            .height = map->height,
+            .radius = (int)header.radius,
+            .offsets = malloc(sizeof(uint32_t) * cells),
+            .data = malloc(header.dataSize > 0 ? header.dataSize : 1),
+            .dataSize = header.dataSize,
+            .dataCapacity = header.dataSize,
+            .syncedEdits = calloc(cells, sizeof(uint32_t)),
+            .stale = calloc(cells, 1),
+        };
+        ok = pvs->offsets && pvs->data && pvs->syncedEdits && pvs->stale &&
+             fread(pvs->offsets, sizeof(uint32_t), cells, file) == cells &&
+             fread(pvs->data, 1, header.dataSize, file) == header.dataSize;
+        // Every set is decoded once here so reads never have to check bounds
+        for (size_t i = 0; ok && i < cells; i++) {
+            bool solid = MapIsSolid(map, (int)(i % map->width), (int)(i / map->width));
+            ok = solid ? pvs->offsets[i] == PVS_NO_ENTRY
+                       : pvs->offsets[i] < header.dataSize &&
+                             CheckEntry(pvs->data, header.dataSize, pvs->offsets[i], pvs->radius);
+        }
+    }
+    fclose(file);
+    if (!ok) PvsFree(pvs);
+    return ok;
+}
+
+// Reads the stored set as is, stale or not
+static bool ReadContains(const Pvs* pvs, int fromX, int fromY, int x, int y) {
+    if (fromX < 0 || fromY < 0 || fromX >= pvs->width || fromY >= pvs->height) return false;
+    uint32_t offset = pvs->offsets[fromY * pvs->width + fromX];
+    int size = 2 * pvs->radius + 1;
+    int localX = x - fromX + pvs->radius, localY = y - fromY + pvs->radius;
+    if (offset == PVS_NO_ENTRY || localX < 0 || localY < 0 || localX >= size || localY >= size) return false;
+
+    uint32_t position = (uint32_t)(localY * size + localX);
+    const uint8_t* in = pvs->data + offset;
+    uint32_t runs = ReadVarint(&in);
+    uint32_t start = 0;
+    for (uint32_t i = 0; i < runs; i++) {
+        start += ReadVarint(&in);
+        if (position < start) return i & 1;
+    }
+    return false;
+}
+
+// Stores a new set for one cell: in place when it fits, appended otherwise
+static bool ReplaceEntry(Pvs* pvs, int x, int y, const uint8_t* entry, size_t length) {
+    uint32_t* offset = &pvs->offsets[y * pvs->width + x];
+    size_t oldLength = *offset == PVS_NO_ENTRY ? 0 : GetEntrySize(pvs->data + *offset);
+    if (*offset != PVS_NO_ENTRY && length <= oldLength) {
+        memcpy(pvs->data + *offset, entry, length);
+        pvs->deadBytes += oldLength - length;
+        return true;
+    }
+    if (pvs->dataSize + length >= PVS_NO_ENTRY) return false;
+    if (pvs->dataSize + length > pvs->dataCapacity) {
+        size_t capacity = pvs->dataCapacity * 2 > pvs->dataSize + length ? pvs->dataCapacity * 2
+                                                                          : pvs->dataSize + length;
+        uint8_t* grown = realloc(pvs->data, capacity);
+        if (!grown) return false;
+        pvs->data = grown;
+        pvs->dataCapacity = capacity;
+    }
+    memcpy(pvs->data + pvs->dataSize, entry, length);
+    *offset = (uint32_t)pvs->dataSize;
+    pvs->dataSize += length;
+    pvs->deadBytes += oldLength;
+    return true;
+}
+
+// Moves the live sets back to back, dropping space abandoned by updates
+static void CompactSets(Pvs* pvs) {
+    size_t cells = (size_t)pvs->width * pvs->height;
+    size_t live = 0;
+    for (size_t i = 0; i < cells; i++) {
+        if (pvs->offsets[i] != PVS_NO_ENTRY) live += GetEntrySize(pvs->data + pvs->offsets[i]);
+    }
+    uint8_t* data = malloc(live > 0 ? live : 1);
+    if (!data) return;
+    size_t used = 0;
+    for (size_t i = 0; i < cells; i++) {
+        if (pvs->offsets[i] == PVS_NO_ENTRY) continue;
+        size_t length = GetEntrySize(pvs->data + pvs->offsets[i]);
+        memcpy(data + used, pvs->data + pvs->offsets[i], length);
+        pvs->offsets[i] = (uint32_t)used;
+        used += length;
+    }
+    free(pvs->data);
+    pvs->data = data;
+    pvs->dataSize = used;
+    pvs->dataCapacity = live;
+    pvs->deadBytes = 0;
+}
+
+// Rebuilds the set when an edit it has not seen lies inside its window; an
+// edit outside the window cannot change what the set covers
+static void SyncCell(Pvs* pvs, int x, int y) {
+    size_t cell = (size_t)y * pvs->width + x;
+    uint32_t* synced = &pvs->syncedEdits[cell];
+    bool stale = pvs->stale[cell];
+    for (uint32_t e = *synced > pvs->editBase ? *synced : pvs->editBase; e < pvs->editCount && !stale; e++) {
+        const PvsEdit* edit = &pvs->pending[e - pvs->editBase];
+        stale = abs(edit->x - x) <= pvs->radius && abs(edit->y - y) <= pvs->radius;
+    }
+    *synced = pvs->editCount;
+    pvs->stale[cell] = 0;
+    if (!stale) return;
+
+    uint32_t* offset = &pvs->offsets[y * pvs->width + x];
+    pvs->generation++;
+    if (MapIsSolid(pvs->map, x, y)) {
+        if (*offset != PVS_NO_ENTRY) pvs->deadBytes += GetEntrySize(pvs->data + *offset);
+        *offset = PVS_NO_ENTRY;
+        return;
+    }
+    PvsScratch scratch;
+    if (PvsScratchInit(&scratch, pvs->radius)) {
+        ComputeCellSet(pvs->map, x, y, &scratch);
+        size_t length = EncodeCellSet(scratch.state, pvs->radius, scratch.entry);
+        if (!ReplaceEntry(pvs, x, y, scratch.entry, length)) fprintf(stderr, "pvs: cannot grow set storage\n");
+        PvsScratchFree(&scratch);
+    } else {
+        fprintf(stderr, "pvs: cannot rebuild set\n");
+    }
+    if (pvs->deadBytes > pvs->dataSize / 2) CompactSets(pvs);
+}
+
+void PvsMarkEdit(Pvs* pvs, int x, int y) {
+    if (pvs->editCount - pvs->editBase == PVS_MAX_PENDING) PvsFlush(pvs);
+    pvs->pending[pvs->editCount - pvs->editBase] = (PvsEdit){x, y};
+    pvs->editCount++;
+}
+
+void PvsFlush(Pvs* pvs) {
+    for (uint32_t e = pvs->editBase; e < pvs->editCount; e++) {
+        const PvsEdit* edit = &pvs->pending[e - pvs->editBase];
+        int x0 = edit->x - pvs->radius < 0 ? 0 : edit->x - pvs->radius;
+        int y0 = edit->y - pvs->radius < 0 ? 0 : edit->y - pvs->radius;
+        int x1 = edit->x + pvs->radius >= pvs->width ? pvs->width - 1 : edit->x + pvs->radius;
+        int y1 = edit->y + pvs->radius >= pvs->height ? pvs->height - 1 : edit->y + pvs->radius;
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                if (pvs->syncedEdits[(size_t)y * pvs->width + x] <= e) pvs->stale[(size_t)y * pvs->width + x] = 1;
+            }
+        }
+    }
+    // Cells outside every window were never affected, so older counts just read as up to date
+    pvs->editBase = pvs->editCount;
+}
+
+// Writes the sets back to back, leaving out the space updates abandoned
+bool PvsSave(Pvs* pvs, const char* path) {
+    PvsFlush(pvs);
+    for (int y = 0; y < pvs->height; y++) {
+        for (int x = 0; x < pvs->width; x++) SyncCell(pvs, x, y);
+    }
+    size_t cells = (size_t)pvs->width * pvs->height;
+    uint32_t* offsets = malloc(sizeof(uint32_t) * cells);
+    if (!offsets) return false;
+    PvsFileHeader header = {
+        .magic = PVS_FILE_MAGIC,
+        .version = PVS_FILE_VERSION,
+        .width = (uint32_t)pvs->width,
+        .height = (uint32_t)pvs->height,
+        .radius = (uint32_t)pvs->radius,
+        .mapHash = MapHashBits(pvs->map),
+    };
+    for (size_t i = 0; i < cells; i++) {
+        if (pvs->offsets[i] == PVS_NO_ENTRY) {
+            offsets[i] = PVS_NO_ENTRY;
+            continue;
+        }
+        offsets[i] = (uint32_t)header.dataSize;
+        header.dataSize += GetEntrySize(pvs->data + pvs->offsets[i]);
+    }
+
+    FILE* file = fopen(path, "wb");
+    bool ok = file && fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(offsets, sizeof(uint32_t), cells, file) == cells;
+    for (size_t i = 0; ok && i < cells; i++) {
+        if (pvs->offsets[i] == PVS_NO_ENTRY) continue;
+        const uint8_t* entry = pvs->data + pvs->offsets[i];
+        size_t length = GetEntrySize(entry);
+        ok = fwrite(entry, 1, length, file) == length;
+    }
+    if (file && fclose(file) != 0) ok = false;
+    free(offsets);
+    return ok;
+}
+
+bool PvsContains(Pvs* pvs, int fromX, int fromY, int x, int y) {
+    if (fromX < 0 || fromY < 0 || fromX >= pvs->width || fromY >= pvs->height) return false;
+    SyncCell(pvs, fromX, fromY);
+    return ReadContains(pvs, fromX, fromY, x, y);
+}
+
+size_t PvsCountVisible(Pvs* pvs, int x, int y) {
+    SyncCell(pvs, x, y);
+    uint32_t offset = pvs->offsets[y * pvs->width + x];
+    if (offset == PVS_NO_ENTRY) return 0;
+    const uint8_t* in = pvs->data + offset;
+    uint32_t runs = ReadVarint(&in);
+    size_t visible = 0;
+    for (uint32_t i = 0; i < runs; i++) {
+        uint32_t length = ReadVarint(&in);
+        if (i & 1) visible += length;
+    }
+    return visible;
+}
+
+bool PvsViewInit(PvsView* view, const Pvs* pvs) {
+    int size = 2 * pvs->radius + 1;
+    *view = (PvsView){.cellX = -1, .cellY = -1, .radius = pvs->radius, .wordsPerRow = (size + 63) / 64};
+    view->bits = calloc((size_t)size * view->wordsPerRow, sizeof(uint64_t));
+    return view->bits != NULL;
+}
+
+void PvsViewFree(PvsView* view) {
+    free(view->bits);
+    *view = (PvsView){.cellX = -1, .cellY = -1};
+}
+
+void PvsViewSetCell(PvsView* view, Pvs* pvs, int x, int y) {
+    bool inside = x >= 0 && y >= 0 && x < pvs->width && y < pvs->height;
+    if (inside) SyncCell(pvs, x, y);
+    if (view->cellX == x && view->cellY == y && view->generation == pvs->generation) return;
+    int size = 2 * view->radius + 1;
+    memset(view->bits, 0, sizeof(uint64_t) * size * view->wordsPerRow);
+    view->cellX = x;
+    view->cellY = y;
+    view->generation = pvs->generation;
+    view->noSet = !inside || pvs->offsets[y * pvs->width + x] == PVS_NO_ENTRY;
+    if (view->noSet) return;
+    uint32_t offset = pvs->offsets[y * pvs->width + x];
+
+    const uint8_t* in = pvs->data + offset;
+    uint32_t runs = ReadVarint(&in);
+    uint32_t position = 0;
+    for (uint32_t i = 0; i < runs; i++) {
+        uint32_t length = ReadVarint(&in);
+        if (i & 1) {
+            for (uint32_t p = position; p < position + length; p++) {
+                int localX = (int)(p % size), localY = (int)(p / size);
+                view->bits[(size_t)localY * view->wordsPerRow + (localX >> 6)] |= 1ull << (localX & 63);
+            }
+        }
+        position += length;
+    }
+}
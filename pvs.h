@@ -0,0 +1,108 @@
+#ifndef PVS_H
+#define PVS_H
+
+#include "threadpool.h"
+#include "world.h"
+
+// Potentially visible set: for every free cell, the cells (walls included)
+// that can be seen from some point inside it, out to a Chebyshev radius.
+// A cell counts as visible when any line from a point of the one cell to a
+// point of the other stays out of the inside of every wall (precise
+// permissive field of view), so a set may hold a cell nothing quite sees but
+// never leaves out one that can be seen: anything outside it can be culled.
+// Each set covers the (2r + 1)^2 window around its cell and is stored as run
+// lengths over that window.
+#define PVS_FILE_MAGIC "RPVS"
+#define PVS_FILE_VERSION 2
+#define PVS_DEFAULT_RADIUS 24
+#define PVS_MAX_RADIUS 255 // Keeps a window's cell count and run lengths well inside 32 bits
+#define PVS_NO_ENTRY 0xFFFFFFFFu // Offset of wall cells
+#define PVS_MAX_PENDING 256 // Edits held back before every set they touch is rechecked
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t radius;
+    uint32_t reserved;
+    uint64_t mapHash; // Occupancy the sets were built from
+    uint64_t dataSize;
+} PvsFileHeader;
+
+typedef struct {
+    int x;
+    int y;
+} PvsEdit;
+
+// Map edits are only logged; a set is checked against the edits it has not
+// seen yet (and rebuilt if one lies inside its window) the next time it is
+// read, so an edit costs nothing until someone looks from near it.
+typedef struct {
+    const Map* map; // Occupancy the sets follow
+    int width;
+    int height;
+    int radius;
+    uint32_t* offsets; // Per cell byte offset into data, PVS_NO_ENTRY for walls
+    uint8_t* data; // Varint run count, then alternating hidden/visible varint run lengths
+    size_t dataSize;
+    size_t dataCapacity;
+    size_t deadBytes; // Left behind by updated sets, dropped on save
+    unsigned generation; // Bumped by every set rebuilt
+    uint32_t* syncedEdits; // Per cell edit count its set was last checked at
+    uint8_t* stale; // Per cell: an edit in its window left the log before the set was checked
+    PvsEdit pending[PVS_MAX_PENDING]; // Edits editBase..editCount - 1
+    uint32_t editBase;
+    uint32_t editCount;
+} Pvs;
+
+// One decoded set, for repeated queries while the viewer stays in one cell
+typedef struct {
+    int cellX; // -1 until set
+    int cellY;
+    int radius;
+    int wordsPerRow;
+    unsigned generation;
+    bool noSet; // Viewer in a wall or off the map: bits are empty
+    uint64_t* bits; // (2r + 1) rows of the window around the cell
+} PvsView;
+
+bool PvsBuild(Pvs* pvs, const Map* map, int radius, ThreadPool* pool);
+void PvsFree(Pvs* pvs);
+// Fails when the file is missing, malformed or was built from different occupancy
+bool PvsLoad(Pvs* pvs, const Map* map, const char* path);
+// Brings every set up to date first
+bool PvsSave(Pvs* pvs, const char* path);
+
+// Whether (x, y) is in the set of free cell (fromX, fromY)
+bool PvsContains(Pvs* pvs, int fromX, int fromY, int x, int y);
+// Logs a change of (x, y); call after the map changed
+void PvsMarkEdit(Pvs* pvs, int x, int y);
+// Marks every set a logged edit can affect for rebuilding and clears the log
+void PvsFlush(Pvs* pvs);
+size_t PvsCountVisible(Pvs* pvs, int x, int y);
+
+bool PvsViewInit(PvsView* view, const Pvs* pvs);
+void PvsViewFree(PvsView* view);
+// Decodes the set of (x, y) unless it is already current; a wall cell gives an empty set
+void PvsViewSetCell(PvsView* view, Pvs* pvs, int x, int y);
+
+static inline bool PvsViewIsVisible(const PvsView* view, int x, int y) {
+    int localX = x - view->cellX + view->radius;
+    int localY = y - view->cellY + view->radius;
+    int size = 2 * view->radius + 1;
+    if (view->cellX < 0 || localX < 0 || localY < 0 || localX >= size || localY >= size) return false;
+    return (view->bits[(size_t)localY * view->wordsPerRow + (localX >> 6)] >> (localX & 63)) & 1;
+}
+
+// For culling: false only for cells the set rules out, so cells beyond the
+// window (or any cell while no set is decoded) may be seen
+static inline bool PvsViewMaySee(const PvsView* view, int x, int y) {
+    int localX = x - view->cellX + view->radius;
+    int localY = y - view->cellY + view->radius;
+    int size = 2 * view->radius + 1;
+    if (view->cellX < 0 || view->noSet || localX < 0 || localY < 0 || localX >= size || localY >= size) return true;
+    return (view->bits[(size_t)localY * view->wordsPerRow + (localX >> 6)] >> (localX & 63)) & 1;
+}
+
+#endif
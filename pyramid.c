@@ -0,0 +1,73 @@
+#include "pyramid.h"
+#include <stdlib.h>
+
+// Reads count (<= 32) occupancy bits for cells x .. x + count - 1 of row y
+static uint32_t ReadRowBits(const Map* map, int x, int y, int count) {
+    const uint64_t* row = map->bits + (size_t)(y + 1) * map->stride;
+    unsigned bit = (unsigned)(x + 1);
+    uint64_t low = row[bit >> 6] >> (bit & 63);
+    if ((bit & 63) + count > 64) low |= row[(bit >> 6) + 1] << (64 - (bit & 63));
+    return (uint32_t)(low & ((1ull << count) - 1));
+}
+
+bool PyramidBuild(Pyramid* pyramid, const Map* map) {
+    int fineSize = 1 << PYRAMID_FINE_SHIFT;
+    int coarseSize = 1 << PYRAMID_COARSE_SHIFT;
+    *pyramid = (Pyramid){
+        .fineWidth = (map->width + fineSize - 1) / fineSize,
+        .fineHeight = (map->height + fineSize - 1) / fineSize,
+        .coarseWidth = (map->width + coarseSize - 1) / coarseSize,
+        .coarseHeight = (map->height + coarseSize - 1) / coarseSize,
+    };
+    pyramid->fine = calloc((size_t)pyramid->fineWidth * pyramid->fineHeight, sizeof(uint8_t));
+    pyramid->coarse = calloc((size_t)pyramid->coarseWidth * pyramid->coarseHeight, sizeof(uint16_t));
+    if (!pyramid->fine || !pyramid->coarse) {
+        PyramidFree(pyramid);
+        return false;
+    }
+
+    for (int by = 0; by < pyramid->fineHeight; by++) {
+        uint8_t* dst = pyramid->fine + (size_t)by * pyramid->fineWidth;
+        for (int row = by * fineSize; row < (by + 1) * fineSize; row++) {
+            if (row >= map->height) {
+                for (int bx = 0; bx < pyramid->fineWidth; bx++) dst[bx] += fineSize;
+                continue;
+            }
+            for (int bx = 0; bx < pyramid->fineWidth; bx++) {
+                int x = bx * fineSize;
+                int inside = map->width - x < fineSize ? map->width - x : fineSize;
+                dst[bx] += __builtin_popcount(ReadRowBits(map, x, row, inside)) + (fineSize - inside);
+            }
+        }
+    }
+
+    int ratio = coarseSize / fineSize;
+    for (int fy = 0; fy < pyramid->fineHeight; fy++) {
+        for (int fx = 0; fx < pyramid->fineWidth; fx++) {
+            pyramid->coarse[(size_t)(fy / ratio) * pyramid->coarseWidth + fx / ratio] +=
+                pyramid->fine[(size_t)fy * pyramid->fineWidth + fx];
+        }
+    }
+    // Fine blocks that fall entirely outside the map still need to block the coarse level
+    for (int cy = 0; cy < pyramid->coarseHeight; cy++) {
+        for (int cx = 0; cx < pyramid->coarseWidth; cx++) {
+            int missingX = (cx + 1) * ratio - pyramid->fineWidth;
+            int missingY = (cy + 1) * ratio - pyramid->fineHeight;
+            if (missingX > 0 || missingY > 0) pyramid->coarse[(size_t)cy * pyramid->coarseWidth + cx] += 1;
+        }
+    }
+    return true;
+}
+
+void PyramidFree(Pyramid* pyramid) {
+    free(pyramid->fine);
+    free(pyramid->coarse);
+    *pyramid = (Pyramid){0};
+}
+
+void PyramidUpdateCell(Pyramid* pyramid, int x, int y, bool wasSolid, bool isSolid) {
+    if (wasSolid == isSolid) return;
+    int delta = isSolid ? 1 : -1;
+    pyramid->fine[(size_t)(y >> PYRAMID_FINE_SHIFT) * pyramid->fineWidth + (x >> PYRAMID_FINE_SHIFT)] += delta;
+    pyramid->coarse[(size_t)(y >> PYRAMID_COARSE_SHIFT) * pyramid->coarseWidth + (x >> PYRAMID_COARSE_SHIFT)] += delta;
+}
@@ -0,0 +1,36 @@
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include "world.h"
+
+// Solid-cell counts over 4x4 and 16x16 blocks of a Map. A zero count means
+// the whole block is empty and a ray can cross it in one jump. Blocks that
+// hang over the map edge count their outside cells as solid.
+#define PYRAMID_LEVELS 2
+#define PYRAMID_FINE_SHIFT 2
+#define PYRAMID_COARSE_SHIFT 4
+
+typedef struct {
+    int fineWidth;
+    int fineHeight;
+    int coarseWidth;
+    int coarseHeight;
+    uint8_t* fine; // 4x4 blocks, 0..16
+    uint16_t* coarse; // 16x16 blocks, 0..256
+} Pyramid;
+
+bool PyramidBuild(Pyramid* pyramid, const Map* map);
+void PyramidFree(Pyramid* pyramid);
+// Keeps the counts in step with one cell changing between solid and empty
+void PyramidUpdateCell(Pyramid* pyramid, int x, int y, bool wasSolid, bool isSolid);
+
+static inline bool PyramidFineEmpty(const Pyramid* pyramid, int x, int y) {
+    return pyramid->fine[(size_t)(y >> PYRAMID_FINE_SHIFT) * pyramid->fineWidth + (x >> PYRAMID_FINE_SHIFT)] == 0;
+}
+
+static inline bool PyramidCoarseEmpty(const Pyramid* pyramid, int x, int y) {
+    return pyramid->coarse[(size_t)(y >> PYRAMID_COARSE_SHIFT) * pyramid->coarseWidth + (x >> PYRAMID_COARSE_SHIFT)] ==
+           0;
+}
+
+#endif
@@ -0,0 +1,473 @@
+#include "raycast.h"
+#include "profile.h"
+#include "raypacket.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Original fixed-step march, kept for comparison
+RayHit CastRayMarch(const Map* map, float originX, float originY, float dirX, float dirY, float maxDistance) {
+    RayHit hit = {RAY_HIT_NONE, maxDistance, 0, -1, -1, 0.0f};
+    float length = sqrtf(dirX * dirX + dirY * dirY);
+    float rayX = originX;
+    float rayY = originY;
+    float rayCos = dirX / length / 32.0f;
+    float raySin = dirY / length / 32.0f;
+    float distance = 0;
+
+    // Marches in world units; distances are reported in units of (dirX, dirY)
+    while (distance < maxDistance * length) {
+        rayX += rayCos;
+        rayY += raySin;
+        distance = sqrtf(powf(rayX - originX, 2) + powf(rayY - originY, 2));
+
+        // The solid border stops the march before it can leave the padded grid
+        if (rayX < -1.0f || rayY < -1.0f || rayX >= map->width + 1 || rayY >= map->height + 1) {
+            hit.kind = RAY_HIT_OUTSIDE;
+            hit.distance = distance / length;
+            return hit;
+        }
+
+        int cellX = (int)floorf(rayX);
+        int cellY = (int)floorf(rayY);
+        if (MapIsSolid(map, cellX, cellY)) {
+            hit.kind = RAY_HIT_WALL;
+            hit.distance = distance / length;
+            hit.mapX = cellX;
+            hit.mapY = cellY;
+            return hit;
+        }
+    }
+    return hit;
+}
+
+// Grid traversal (DDA): visits every cell the ray crosses exactly once. The
+// origin must be inside the map; the solid border ends every ray.
+RayHit CastRayDDA(const Map* map, float originX, float originY, float dirX, float dirY, float maxDistance) {
+    RayHit hit = {RAY_HIT_NONE, maxDistance, 0, -1, -1, 0.0f};
+    int mapX = (int)originX;
+    int mapY = (int)originY;
+
+    // Ray length needed to cross one full cell along each axis
+    float deltaDistX = dirX == 0.0f ? INFINITY : fabsf(1.0f / dirX);
+    float deltaDistY = dirY == 0.0f ? INFINITY : fabsf(1.0f / dirY);
+
+    int stepX, stepY;
+    float sideDistX, sideDistY;
+    if (dirX < 0) {
+        stepX = -1;
+        sideDistX = (originX - mapX) * deltaDistX;
+    } else {
+        stepX = 1;
+        sideDistX = (mapX + 1.0f - originX) * deltaDistX;
+    }
+    if (dirY < 0) {
+        stepY = -1;
+        sideDistY = (originY - mapY) * deltaDistY;
+    } else {
+        stepY = 1;
+        sideDistY = (mapY + 1.0f - originY) * deltaDistY;
+    }
+
+    for (;;) {
+        float distance;
+        int side;
+        if (sideDistX < sideDistY) {
+            distance = sideDistX;
+            sideDistX += deltaDistX;
+            mapX += stepX;
+            side = 0;
+        } else {
+            distance = sideDistY;
+            sideDistY += deltaDistY;
+            mapY += stepY;
+            side = 1;
+        }
+
+        if (distance >= maxDistance) return hit;
+
+        if (MapIsSolid(map, mapX, mapY)) {
+            hit.kind = RAY_HIT_WALL;
+            hit.distance = distance;
+            hit.side = side;
+            hit.mapX = mapX;
+            hit.mapY = mapY;
+            return hit;
+        }
+    }
+}
+
+// The DDA above with every quantity in fixed point. Distances need 64 bits:
+// a near-axis ray crosses a cell in up to 2^30 units of its direction.
+RayHit CastRayFixed(const Map* map, Fixed originX, Fixed originY, FixedDir dirX, FixedDir dirY, Fixed maxDistance) {
+    RayHit hit = {RAY_HIT_NONE, FixedToFloat(maxDistance), 0, -1, -1, 0.0f};
+    int mapX = originX >> FIXED_FRACTION_BITS;
+    int mapY = originY >> FIXED_FRACTION_BITS;
+    int64_t deltaDistX = dirX == 0 ? 0 : ((int64_t)FIXED_ONE << FIXED_DIR_BITS) / (dirX < 0 ? -dirX : dirX);
+    int64_t deltaDistY = dirY == 0 ? 0 : ((int64_t)FIXED_ONE << FIXED_DIR_BITS) / (dirY < 0 ? -dirY : dirY);
+    int stepX = dirX < 0 ? -1 : 1;
+    int stepY = dirY < 0 ? -1 : 1;
+    Fixed cellX = (Fixed)mapX << FIXED_FRACTION_BITS;
+    Fixed cellY = (Fixed)mapY << FIXED_FRACTION_BITS;
+    // An axis the ray runs parallel to is never crossed
+    int64_t sideDistX = dirX == 0 ? INT64_MAX
+                                  : (dirX < 0 ? originX - cellX : cellX + FIXED_ONE - originX) * deltaDistX /
+                                        FIXED_ONE;
+    int64_t sideDistY = dirY == 0 ? INT64_MAX
+                                  : (dirY < 0 ? originY - cellY : cellY + FIXED_ONE - originY) * deltaDistY /
+                                        FIXED_ONE;
+
+    for (;;) {
+        int64_t distance;
+        int side;
+        if (sideDistX < sideDistY) {
+            distance = sideDistX;
+            sideDistX += deltaDistX;
+            mapX += stepX;
+            side = 0;
+        } else {
+            distance = sideDistY;
+            sideDistY += deltaDistY;
+            mapY += stepY;
+            side = 1;
+        }
+
+        if (distance >= maxDistance) return hit;
+
+        if (MapIsSolid(map, mapX, mapY)) {
+            // Texture coordinate as in CastColumns, from the fixed-point hit point
+            int64_t along = side == 0 ? originY + distance * dirY / FIXED_DIR_ONE
+                                      : originX + distance * dirX / FIXED_DIR_ONE;
+            int64_t wallX = along & (FIXED_ONE - 1);
+            if ((side == 0 && dirX > 0) || (side == 1 && dirY < 0)) wallX = FIXED_ONE - wallX;
+            hit.kind = RAY_HIT_WALL;
+            hit.distance = FixedToFloat(distance);
+            hit.side = side;
+            hit.mapX = mapX;
+            hit.mapY = mapY;
+            hit.wallX = FixedToFloat(wallX);
+            return hit;
+        }
+    }
+}
+
+// DDA state shared by the casters that can skip over known-empty regions
+typedef struct {
+    int mapX;
+    int mapY;
+    int stepX;
+    int stepY;
+    float sideDistX;
+    float sideDistY;
+    float deltaDistX;
+    float deltaDistY;
+} GridWalk;
+
+static inline GridWalk GridWalkStart(float originX, float originY, float dirX, float dirY) {
+    GridWalk walk = {.mapX = (int)originX,
+                     .mapY = (int)originY,
+                     .stepX = dirX < 0 ? -1 : 1,
+                     .stepY = dirY < 0 ? -1 : 1,
+                     .deltaDistX = dirX == 0.0f ? INFINITY : fabsf(1.0f / dirX),
+                     .deltaDistY = dirY == 0.0f ? INFINITY : fabsf(1.0f / dirY)};
+    walk.sideDistX = (dirX < 0 ? originX - walk.mapX : walk.mapX + 1.0f - originX) * walk.deltaDistX;
+    walk.sideDistY = (dirY < 0 ? originY - walk.mapY : walk.mapY + 1.0f - originY) * walk.deltaDistY;
+    return walk;
+}
+
+static inline float GridWalkStep(GridWalk* walk, int* side) {
+    float distance;
+    if (walk->sideDistX < walk->sideDistY) {
+        distance = walk->sideDistX;
+        walk->sideDistX += walk->deltaDistX;
+        walk->mapX += walk->stepX;
+        *side = 0;
+    } else {
+        distance = walk->sideDistY;
+        walk->sideDistY += walk->deltaDistY;
+        walk->mapY += walk->stepY;
+        *side = 1;
+    }
+    return distance;
+}
+
+// Leaves the empty box [minX, maxX] x [minY, maxY] around the current cell in
+// one move. The state advances by the number of steps the plain walk would
+// have taken inside the box, so the visited cells still form the same
+// 4-connected path and no wall can be jumped over.
+static inline float GridWalkSkip(GridWalk* walk, int minX, int minY, int maxX, int maxY, int* side) {
+    int countX = walk->stepX > 0 ? maxX + 1 - walk->mapX : walk->mapX - minX + 1;
+    int countY = walk->stepY > 0 ? maxY + 1 - walk->mapY : walk->mapY - minY + 1;
+    float exitX = countX > 1 ? walk->sideDistX + (countX - 1) * walk->deltaDistX : walk->sideDistX;
+    float exitY = countY > 1 ? walk->sideDistY + (countY - 1) * walk->deltaDistY : walk->sideDistY;
+
+    if (exitX < exitY) {
+        for (int inner = 1; inner < countY && walk->sideDistY <= exitX; inner++) {
+            walk->mapY += walk->stepY;
+            walk->sideDistY += walk->deltaDistY;
+        }
+        walk->mapX += countX * walk->stepX;
+        walk->sideDistX = exitX + walk->deltaDistX;
+        *side = 0;
+        return exitX;
+    }
+    for (int inner = 1; inner < countX && walk->sideDistX < exitY; inner++) {
+        walk->mapX += walk->stepX;
+        walk->sideDistX += walk->deltaDistX;
+    }
+    walk->mapY += countY * walk->stepY;
+    walk->sideDistY = exitY + walk->deltaDistY;
+    *side = 1;
+    return exitY;
+}
+
+static inline RayHit WallHit(float distance, int side, int mapX, int mapY) {
+    return (RayHit){RAY_HIT_WALL, distance, side, mapX, mapY, 0.0f};
+}
+
+// Size (as a shift) of the largest empty block around a cell, -1 if none
+static inline int GetEmptyBlockShift(const Map* map, const Pyramid* pyramid, int x, int y) {
+    if (x < 0 || y < 0 || x >= map->width || y >= map->height) return -1;
+    if (PyramidCoarseEmpty(pyramid, x, y)) return PYRAMID_COARSE_SHIFT;
+    if (PyramidFineEmpty(pyramid, x, y)) return PYRAMID_FINE_SHIFT;
+    return -1;
+}
+
+// DDA that crosses empty 16x16 and 4x4 blocks of the pyramid in one jump and
+// only walks cell by cell near geometry
+RayHit CastRayHier(const Map* map, const Pyramid* pyramid, float originX, float originY, float dirX, float dirY,
+                   float maxDistance) {
+    RayHit hit = {RAY_HIT_NONE, maxDistance, 0, -1, -1, 0.0f};
+    GridWalk walk = GridWalkStart(originX, originY, dirX, dirY);
+
+    int shift = GetEmptyBlockShift(map, pyramid, walk.mapX, walk.mapY);
+    for (;;) {
+        float distance;
+        int side;
+        if (shift >= 0) {
+            int blockX = (walk.mapX >> shift) << shift;
+            int blockY = (walk.mapY >> shift) << shift;
+            int size = 1 << shift;
+            distance = GridWalkSkip(&walk, blockX, blockY, blockX + size - 1, blockY + size - 1, &side);
+        } else {
+            distance = GridWalkStep(&walk, &side);
+        }
+
+        if (distance >= maxDistance) return hit;
+
+        // A cell inside an empty block needs no occupancy read
+        shift = GetEmptyBlockShift(map, pyramid, walk.mapX, walk.mapY);
+        if (shift < 0 && MapIsSolid(map, walk.mapX, walk.mapY)) return WallHit(distance, side, walk.mapX, walk.mapY);
+    }
+}
+
+// Sphere tracing on the chessboard distance field: a cell holding d sits in
+// an empty square of radius d - 1, which the ray crosses in one move
+RayHit CastRayField(const Map* map, const DistanceField* field, float originX, float originY, float dirX, float dirY,
+                    float maxDistance) {
+    RayHit hit = {RAY_HIT_NONE, maxDistance, 0, -1, -1, 0.0f};
+    GridWalk walk = GridWalkStart(originX, originY, dirX, dirY);
+
+    int radius = DistanceFieldGet(field, walk.mapX, walk.mapY) - 1;
+    for (;;) {
+        float distance;
+        int side;
+        if (radius > 0) {
+            distance = GridWalkSkip(&walk, walk.mapX - radius, walk.mapY - radius, walk.mapX + radius,
+                                    walk.mapY + radius, &side);
+        } else {
+            distance = GridWalkStep(&walk, &side);
+        }
+
+        if (distance >= maxDistance) return hit;
+
+        // Only the solid border lies outside the field
+        if (walk.mapX < 0 || walk.mapY < 0 || walk.mapX >= map->width || walk.mapY >= map->height) {
+            return WallHit(distance, side, walk.mapX, walk.mapY);
+        }
+        radius = DistanceFieldGet(field, walk.mapX, walk.mapY) - 1;
+        if (radius < 0) return WallHit(distance, side, walk.mapX, walk.mapY);
+    }
+}
+
+bool RayTableInit(RayTable* table, int numRays, float fov) {
+    table->numRays = numRays;
+    table->fov = fov;
+    table->offset = malloc(sizeof(float) * numRays * 9);
+    table->fixedOffset = malloc(sizeof(FixedDir) * numRays);
+    if (!table->offset || !table->fixedOffset) {
+        RayTableFree(table);
+        return false;
+    }
+
+    // Equiangular columns like the original per-ray angles, expressed as the
+    // tangent offset along the camera plane for a forward vector of length 1
+    float rayAngleStep = fov / (float)numRays;
+    for (int i = 0; i < numRays; i++) {
+        table->offset[i] = tanf((-(fov / 2.0f) + i * rayAngleStep) * DEG2RAD);
+    }
+
+    static const float headingCos[4] = {1.0f, 0.0f, -1.0f, 0.0f};
+    static const float headingSin[4] = {0.0f, 1.0f, 0.0f, -1.0f};
+    for (int h = 0; h < 4; h++) {
+        table->headingDirX[h] = table->offset + numRays * (1 + h * 2);
+        table->headingDirY[h] = table->offset + numRays * (2 + h * 2);
+        RotateRayTable(table, headingCos[h], headingSin[h], table->headingDirX[h], table->headingDirY[h]);
+    }
+    for (int i = 0; i < numRays; i++) table->fixedOffset[i] = FixedColumnTan(i, numRays, fov);
+    return true;
+}
+
+void RayTableFree(RayTable* table) {
+    free(table->offset);
+    free(table->fixedOffset);
+    table->offset = NULL;
+    table->fixedOffset = NULL;
+    table->numRays = 0;
+}
+
+bool RayTableEnsure(RayTable* table, int numRays, float fov) {
+    if (table->offset && table->numRays == numRays && table->fov == fov) return true;
+    RayTableFree(table);
+    return RayTableInit(table, numRays, fov);
+}
+
+void RotateRayTable(const RayTable* table, float cosA, float sinA, float* dirX, float* dirY) {
+    for (int i = 0; i < table->numRays; i++) {
+        dirX[i] = cosA - sinA * table->offset[i];
+        dirY[i] = sinA + cosA * table->offset[i];
+    }
+}
+
+void RotateRayTableFixed(const RayTable* table, FixedAngle angle, FixedDir* dirX, FixedDir* dirY) {
+    FixedDir cosA, sinA;
+    FixedSinCos(angle, &sinA, &cosA);
+    for (int i = 0; i < table->numRays; i++) {
+        dirX[i] = cosA - (FixedDir)((int64_t)sinA * table->fixedOffset[i] / FIXED_DIR_ONE);
+        dirY[i] = sinA + (FixedDir)((int64_t)cosA * table->fixedOffset[i] / FIXED_DIR_ONE);
+    }
+}
+
+int GetHeadingIndex(float angle) {
+    if (angle == 0.0f) return 0;
+    if (angle == 90.0f) return 1;
+    if (angle == 180.0f) return 2;
+    if (angle == 270.0f) return 3;
+    return -1;
+}
+
+static const char* casterNames[CASTER_COUNT] = {"dda", "march", "packet", "hier", "field", "fixed"};
+
+const char* GetCasterName(CasterKind caster) {
+    return caster < CASTER_COUNT ? casterNames[caster] : "unknown";
+}
+
+bool ParseCasterName(const char* name, CasterKind* caster) {
+    for (int c = 0; c < CASTER_COUNT; c++) {
+        if (strcmp(name, casterNames[c]) == 0) {
+            *caster = (CasterKind)c;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PrepareCaster(Level* level, CasterKind caster) {
+    if (caster == CASTER_HIER) return LevelEnsurePyramid(level);
+    if (caster == CASTER_FIELD) return LevelEnsureField(level);
+    return true;
+}
+
+void CastColumns(const CastJob* job, int begin, int end) {
+    const Map* map = &job->level->map;
+    switch (job->caster) {
+    case CASTER_MARCH:
+        for (int i = begin; i < end; i++) {
+            job->hits[i] = CastRayMarch(map, job->originX, job->originY, job->dirX[i], job->dirY[i], job->maxDistance);
+        }
+        break;
+    case CASTER_PACKET:
+        CastRayPacket(map, &job->originX, &job->originY, 0, job->dirX + begin, job->dirY + begin, job->maxDistance,
+                      end - begin, job->hits + begin);
+        break;
+    case CASTER_HIER:
+        for (int i = begin; i < end; i++) {
+            job->hits[i] = CastRayHier(map, &job->level->pyramid, job->originX, job->originY, job->dirX[i],
+                                       job->dirY[i], job->maxDistance);
+        }
+        break;
+    case CASTER_FIELD:
+        for (int i = begin; i < end; i++) {
+            job->hits[i] = CastRayField(map, &job->level->field, job->originX, job->originY, job->dirX[i],
+                                        job->dirY[i], job->maxDistance);
+        }
+        break;
+    case CASTER_FIXED: {
+        Fixed originX = FixedFromFloat(job->originX);
+        Fixed originY = FixedFromFloat(job->originY);
+        Fixed maxDistance = FixedFromFloat(job->maxDistance);
+        for (int i = begin; i < end; i++) {
+            job->hits[i] = CastRayFixed(map, originX, originY, job->fixedDirX[i], job->fixedDirY[i], maxDistance);
+        }
+        // Texture coordinates are already set, without float math
+        return;
+    }
+    default:
+        for (int i = begin; i < end; i++) {
+            job->hits[i] = CastRayDDA(map, job->originX, job->originY, job->dirX[i], job->dirY[i], job->maxDistance);
+        }
+        break;
+    }
+
+    // Texture coordinate along the struck face, mirrored for faces seen from +x or -y
+    for (int i = begin; i < end; i++) {
+        RayHit* hit = &job->hits[i];
+        if (hit->kind != RAY_HIT_WALL) continue;
+        float wallX = hit->side == 0 ? job->originY + hit->distance * job->dirY[i]
+                                     : job->originX + hit->distance * job->dirX[i];
+        wallX -= floorf(wallX);
+        if ((hit->side == 0 && job->dirX[i] > 0) || (hit->side == 1 && job->dirY[i] < 0)) wallX = 1.0f - wallX;
+        hit->wallX = wallX;
+    }
+}
+
+static void CastColumnsTask(void* context, int begin, int end) {
+    uint64_t zone = ProfileBegin();
+    CastColumns(context, begin, end);
+    ProfileEnd(PROFILE_CAST_CHUNK, zone);
+}
+
+void CastView(const Level* level, const Player* player, const RayTable* table, CasterKind caster, float maxDistance,
+              RayHit* hits, ThreadPool* pool) {
+    CastJob job = {.level = level,
+                   .originX = player->pos.x + PLAYER_OFFSET,
+                   .originY = player->pos.y + PLAYER_OFFSET,
+                   .caster = caster,
+                   .maxDistance = maxDistance,
+                   .hits = hits};
+    int heading = GetHeadingIndex(player->angle);
+    float* scratch = NULL;
+    FixedDir* fixedScratch = NULL;
+
+    if (caster == CASTER_FIXED) {
+        fixedScratch = malloc(sizeof(FixedDir) * table->numRays * 2);
+        if (!fixedScratch) return;
+        RotateRayTableFixed(table, FixedAngleFromDegrees(player->angle), fixedScratch, fixedScratch + table->numRays);
+        job.fixedDirX = fixedScratch;
+        job.fixedDirY = fixedScratch + table->numRays;
+    } else if (heading >= 0) {
+        job.dirX = table->headingDirX[heading];
+        job.dirY = table->headingDirY[heading];
+    } else {
+        scratch = malloc(sizeof(float) * table->numRays * 2);
+        if (!scratch) return;
+        RotateRayTable(table, cosf(player->angle * DEG2RAD), sinf(player->angle * DEG2RAD), scratch,
+                       scratch + table->numRays);
+        job.dirX = scratch;
+        job.dirY = scratch + table->numRays;
+    }
+
+    ThreadPoolRun(pool, CastColumnsTask, &job, table->numRays);
+    free(scratch);
+    free(fixedScratch);
+}
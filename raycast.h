@@ -0,0 +1,94 @@
+#ifndef RAYCAST_H
+#define RAYCAST_H
+
+#include "fixed.h"
+#include "level.h"
+#include "threadpool.h"
+
+#ifndef PI
+#define PI 3.14159265358979323846f
+#endif
+#ifndef DEG2RAD
+#define DEG2RAD (PI / 180.0f)
+#endif
+
+#define FOV 60.0f
+#define MAX_RAY_DISTANCE 20.0f // Default view distance
+
+typedef enum { RAY_HIT_WALL, RAY_HIT_OUTSIDE, RAY_HIT_NONE } RayHitKind;
+
+typedef enum {
+    CASTER_DDA,
+    CASTER_MARCH,
+    CASTER_PACKET,
+    CASTER_HIER,
+    CASTER_FIELD,
+    CASTER_FIXED, // Integer-only, bit-identical on every build; see fixed.h
+    CASTER_COUNT
+} CasterKind;
+
+typedef struct {
+    RayHitKind kind;
+    float distance; // Distance along the ray in units of (dirX, dirY); perpendicular for camera-plane rays
+    int side; // 0 = crossed a vertical grid line (x), 1 = horizontal (y)
+    int mapX;
+    int mapY;
+    float wallX; // Where the ray struck the face, 0..1 left to right as seen from outside
+} RayHit;
+
+RayHit CastRayMarch(const Map* map, float originX, float originY, float dirX, float dirY, float maxDistance);
+RayHit CastRayDDA(const Map* map, float originX, float originY, float dirX, float dirY, float maxDistance);
+RayHit CastRayHier(const Map* map, const Pyramid* pyramid, float originX, float originY, float dirX, float dirY,
+                   float maxDistance);
+RayHit CastRayField(const Map* map, const DistanceField* field, float originX, float originY, float dirX, float dirY,
+                    float maxDistance);
+// DDA in fixed point, including the texture coordinate
+RayHit CastRayFixed(const Map* map, Fixed originX, Fixed originY, FixedDir dirX, FixedDir dirY, Fixed maxDistance);
+
+const char* GetCasterName(CasterKind caster);
+bool ParseCasterName(const char* name, CasterKind* caster);
+// Builds whatever acceleration structure the caster reads from the level
+bool PrepareCaster(Level* level, CasterKind caster);
+
+// Per-column ray directions for the camera plane. Each direction has a
+// forward component of 1, so traversal distances are already perpendicular
+// to the camera (no fisheye). Rebuilt only when the ray count or FOV changes.
+typedef struct {
+    int numRays;
+    float fov;
+    float* offset; // Camera-space offset along the plane, per column
+    float* headingDirX[4]; // World-space tables for the 0/90/180/270 headings
+    float* headingDirY[4];
+    FixedDir* fixedOffset; // The same offsets from integer math, for CASTER_FIXED
+} RayTable;
+
+bool RayTableInit(RayTable* table, int numRays, float fov);
+void RayTableFree(RayTable* table);
+bool RayTableEnsure(RayTable* table, int numRays, float fov);
+void RotateRayTable(const RayTable* table, float cosA, float sinA, float* dirX, float* dirY);
+void RotateRayTableFixed(const RayTable* table, FixedAngle angle, FixedDir* dirX, FixedDir* dirY);
+int GetHeadingIndex(float angle); // 0..3 for the four discrete headings, -1 otherwise
+
+// One view's worth of rays; columns only read the level and the job, so any
+// column range can be cast on any thread
+typedef struct {
+    const Level* level;
+    float originX;
+    float originY;
+    const float* dirX;
+    const float* dirY;
+    const FixedDir* fixedDirX; // CASTER_FIXED reads these instead
+    const FixedDir* fixedDirY;
+    CasterKind caster;
+    float maxDistance;
+    RayHit* hits;
+} CastJob;
+
+void CastColumns(const CastJob* job, int begin, int end);
+
+// Casts table->numRays columns into hits[0..numRays), spread over pool (may be NULL).
+// The level must have been through PrepareCaster for this caster.
+void CastView(const Level* level, const Player* player, const RayTable* table, CasterKind caster, float maxDistance,
+              RayHit* hits, ThreadPool* pool);
+
+#endif
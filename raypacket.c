@@ -0,0 +1,216 @@
+#include "raypacket.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+typedef struct {
+    const float* originX;
+    const float* originY;
+    int originStride;
+    const float* dirX;
+    const float* dirY;
+    const Map* map;
+    float maxDistance;
+} PacketInput;
+
+typedef void (*PacketKernelFn)(const PacketInput* in, int begin, int end, RayHit* hits);
+
+static void CastPacketScalar(const PacketInput* in, int begin, int end, RayHit* hits) {
+    for (int i = begin; i < end; i++) {
+        hits[i] = CastRayDDA(in->map, in->originX[i * in->originStride], in->originY[i * in->originStride], in->dirX[i],
+                             in->dirY[i], in->maxDistance);
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+
+// Occupancy bits are read as 32-bit words: cell (x, y) is bit (x + 1) & 31 of
+// word (y + 1) * stride * 2 + ((x + 1) >> 5) (little-endian halves of the rows)
+
+// SSE2: 4 lanes, no gather or blendv, so those are emulated
+static __m128i TestWallsSSE2(const Map* map, __m128i mapX, __m128i mapY, __m128i mask) {
+    int32_t x[4], y[4], m[4], out[4];
+    _mm_storeu_si128((__m128i*)x, mapX);
+    _mm_storeu_si128((__m128i*)y, mapY);
+    _mm_storeu_si128((__m128i*)m, mask);
+    for (int lane = 0; lane < 4; lane++) out[lane] = m[lane] && MapIsSolid(map, x[lane], y[lane]) ? -1 : 0;
+    return _mm_loadu_si128((const __m128i*)out);
+}
+
+__attribute__((target("avx2"))) static inline __m256i TestWallsAVX2(const Map* map, __m256i mapX, __m256i mapY,
+                                                                    __m256i mask) {
+    __m256i bit = _mm256_add_epi32(mapX, _mm256_set1_epi32(1));
+    __m256i row = _mm256_mullo_epi32(_mm256_add_epi32(mapY, _mm256_set1_epi32(1)), _mm256_set1_epi32(map->stride * 2));
+    __m256i index = _mm256_add_epi32(row, _mm256_srli_epi32(bit, 5));
+    __m256i words = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*)map->bits, index, mask, 4);
+    __m256i solid = _mm256_and_si256(_mm256_srlv_epi32(words, _mm256_and_si256(bit, _mm256_set1_epi32(31))),
+                                     _mm256_set1_epi32(1));
+    return _mm256_and_si256(mask, _mm256_cmpgt_epi32(solid, _mm256_setzero_si256()));
+}
+
+__attribute__((target("avx512f"))) static inline __mmask16 TestWallsAVX512(const Map* map, __m512i mapX,
+                                                                           __m512i mapY, __mmask16 mask) {
+    __m512i bit = _mm512_add_epi32(mapX, _mm512_set1_epi32(1));
+    __m512i row = _mm512_mullo_epi32(_mm512_add_epi32(mapY, _mm512_set1_epi32(1)), _mm512_set1_epi32(map->stride * 2));
+    __m512i index = _mm512_add_epi32(row, _mm512_srli_epi32(bit, 5));
+    __m512i words = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), mask, index, (const int*)map->bits, 4);
+    __m512i solid = _mm512_srlv_epi32(words, _mm512_and_si512(bit, _mm512_set1_epi32(31)));
+    return _mm512_mask_test_epi32_mask(mask, solid, _mm512_set1_epi32(1));
+}
+
+#define KERNEL_NAME CastPacketSSE2
+#define KERNEL_TARGET __attribute__((target("sse2")))
+#define LANES 4
+#define VF __m128
+#define VI __m128i
+#define VM __m128i
+#define F_LOAD(p) _mm_loadu_ps(p)
+#define F_STORE(p, v) _mm_storeu_ps(p, v)
+#define F_SET1(x) _mm_set1_ps(x)
+#define F_ADD(a, b) _mm_add_ps(a, b)
+#define F_SUB(a, b) _mm_sub_ps(a, b)
+#define F_MUL(a, b) _mm_mul_ps(a, b)
+#define F_DIV(a, b) _mm_div_ps(a, b)
+#define F_ABS(a) _mm_andnot_ps(_mm_set1_ps(-0.0f), a)
+#define F_FROM_I(v) _mm_cvtepi32_ps(v)
+#define F_BLEND(a, b, m) _mm_or_ps(_mm_andnot_ps(_mm_castsi128_ps(m), a), _mm_and_ps(_mm_castsi128_ps(m), b))
+#define I_SET1(x) _mm_set1_epi32(x)
+#define I_STORE(p, v) _mm_storeu_si128((__m128i*)(p), v)
+#define I_ADD(a, b) _mm_add_epi32(a, b)
+#define I_FROM_F_TRUNC(v) _mm_cvttps_epi32(v)
+#define I_BLEND(a, b, m) _mm_or_si128(_mm_andnot_si128(m, a), _mm_and_si128(m, b))
+#define M_ALL() _mm_set1_epi32(-1)
+#define M_ANY(m) (_mm_movemask_epi8(m) != 0)
+#define M_AND(a, b) _mm_and_si128(a, b)
+#define M_ANDNOT(a, b) _mm_andnot_si128(a, b)
+#define M_FLT(a, b) _mm_castps_si128(_mm_cmplt_ps(a, b))
+#define M_FGE(a, b) _mm_castps_si128(_mm_cmpge_ps(a, b))
+#define M_WALL(map, x, y, m) TestWallsSSE2(map, x, y, m)
+#include "raypacket_kernel.h"
+#include "raypacket_undef.h"
+
+#define KERNEL_NAME CastPacketAVX2
+#define KERNEL_TARGET __attribute__((target("avx2")))
+#define LANES 8
+#define VF __m256
+#define VI __m256i
+#define VM __m256i
+#define F_LOAD(p) _mm256_loadu_ps(p)
+#define F_STORE(p, v) _mm256_storeu_ps(p, v)
+#define F_SET1(x) _mm256_set1_ps(x)
+#define F_ADD(a, b) _mm256_add_ps(a, b)
+#define F_SUB(a, b) _mm256_sub_ps(a, b)
+#define F_MUL(a, b) _mm256_mul_ps(a, b)
+#define F_DIV(a, b) _mm256_div_ps(a, b)
+#define F_ABS(a) _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a)
+#define F_FROM_I(v) _mm256_cvtepi32_ps(v)
+#define F_BLEND(a, b, m) _mm256_blendv_ps(a, b, _mm256_castsi256_ps(m))
+#define I_SET1(x) _mm256_set1_epi32(x)
+#define I_STORE(p, v) _mm256_storeu_si256((__m256i*)(p), v)
+#define I_ADD(a, b) _mm256_add_epi32(a, b)
+#define I_FROM_F_TRUNC(v) _mm256_cvttps_epi32(v)
+#define I_BLEND(a, b, m) _mm256_blendv_epi8(a, b, m)
+#define M_ALL() _mm256_set1_epi32(-1)
+#define M_ANY(m) (!_mm256_testz_si256(m, m))
+#define M_AND(a, b) _mm256_and_si256(a, b)
+#define M_ANDNOT(a, b) _mm256_andnot_si256(a, b)
+#define M_FLT(a, b) _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_LT_OQ))
+#define M_FGE(a, b) _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_GE_OQ))
+#define M_WALL(map, x, y, m) TestWallsAVX2(map, x, y, m)
+#include "raypacket_kernel.h"
+#include "raypacket_undef.h"
+
+#define KERNEL_NAME CastPacketAVX512
+#define KERNEL_TARGET __attribute__((target("avx512f")))
+#define LANES 16
+#define VF __m512
+#define VI __m512i
+#define VM __mmask16
+#define F_LOAD(p) _mm512_loadu_ps(p)
+#define F_STORE(p, v) _mm512_storeu_ps(p, v)
+#define F_SET1(x) _mm512_set1_ps(x)
+#define F_ADD(a, b) _mm512_add_ps(a, b)
+#define F_SUB(a, b) _mm512_sub_ps(a, b)
+#define F_MUL(a, b) _mm512_mul_ps(a, b)
+#define F_DIV(a, b) _mm512_div_ps(a, b)
+#define F_ABS(a) _mm512_abs_ps(a)
+#define F_FROM_I(v) _mm512_cvtepi32_ps(v)
+#define F_BLEND(a, b, m) _mm512_mask_blend_ps(m, a, b)
+#define I_SET1(x) _mm512_set1_epi32(x)
+#define I_STORE(p, v) _mm512_storeu_si512((void*)(p), v)
+#define I_ADD(a, b) _mm512_add_epi32(a, b)
+#define I_FROM_F_TRUNC(v) _mm512_cvttps_epi32(v)
+#define I_BLEND(a, b, m) _mm512_mask_blend_epi32(m, a, b)
+#define M_ALL() ((__mmask16)0xFFFF)
+#define M_ANY(m) ((m) != 0)
+#define M_AND(a, b) ((__mmask16)((a) & (b)))
+#define M_ANDNOT(a, b) ((__mmask16)(~(a) & (b)))
+#define M_FLT(a, b) _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ)
+#define M_FGE(a, b) _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ)
+#define M_WALL(map, x, y, m) TestWallsAVX512(map, x, y, m)
+#include "raypacket_kernel.h"
+#include "raypacket_undef.h"
+
+#endif
+
+static const char* kernelNames[PACKET_KERNEL_COUNT] = {"scalar", "sse2", "avx2", "avx512"};
+static PacketKernelFn kernelFns[PACKET_KERNEL_COUNT] = {
+    CastPacketScalar,
+#ifdef HAVE_X86_KERNELS
+    CastPacketSSE2, CastPacketAVX2, CastPacketAVX512,
+#endif
+};
+
+static pthread_once_t detectOnce = PTHREAD_ONCE_INIT;
+static PacketKernel bestKernel = PACKET_SCALAR;
+static PacketKernel activeKernel = PACKET_SCALAR;
+
+static void DetectPacketKernel(void) {
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        bestKernel = PACKET_AVX512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        bestKernel = PACKET_AVX2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        bestKernel = PACKET_SSE2;
+    }
+#endif
+    activeKernel = bestKernel;
+}
+
+PacketKernel GetPacketKernel(void) {
+    pthread_once(&detectOnce, DetectPacketKernel);
+    return activeKernel;
+}
+
+PacketKernel SetPacketKernel(PacketKernel kernel) {
+    pthread_once(&detectOnce, DetectPacketKernel);
+    activeKernel = kernel < bestKernel ? kernel : bestKernel;
+    return activeKernel;
+}
+
+const char* GetPacketKernelName(PacketKernel kernel) {
+    return kernel < PACKET_KERNEL_COUNT ? kernelNames[kernel] : "unknown";
+}
+
+bool ParsePacketKernelName(const char* name, PacketKernel* kernel) {
+    for (int k = 0; k < PACKET_KERNEL_COUNT; k++) {
+        if (strcmp(name, kernelNames[k]) == 0) {
+            *kernel = (PacketKernel)k;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CastRayPacket(const Map* map, const float* originX, const float* originY, int originStride, const float* dirX,
+                   const float* dirY, float maxDistance, int count, RayHit* hits) {
+    PacketInput in = {originX, originY, originStride, dirX, dirY, map, maxDistance};
+    kernelFns[GetPacketKernel()](&in, 0, count, hits);
+}
@@ -0,0 +1,20 @@
+#ifndef RAYPACKET_H
+#define RAYPACKET_H
+
+#include "raycast.h"
+
+// Packet DDA: advances 4/8/16 rays per step with the widest kernel the CPU
+// supports. Every kernel returns exactly what CastRayDDA returns per ray.
+typedef enum { PACKET_SCALAR, PACKET_SSE2, PACKET_AVX2, PACKET_AVX512, PACKET_KERNEL_COUNT } PacketKernel;
+
+PacketKernel GetPacketKernel(void);
+// Forces a kernel (for comparisons); falls back to the best supported one below it
+PacketKernel SetPacketKernel(PacketKernel kernel);
+const char* GetPacketKernelName(PacketKernel kernel);
+bool ParsePacketKernelName(const char* name, PacketKernel* kernel);
+
+// originStride 0 shares one origin between all rays, 1 reads one per ray
+void CastRayPacket(const Map* map, const float* originX, const float* originY, int originStride, const float* dirX,
+                   const float* dirY, float maxDistance, int count, RayHit* hits);
+
+#endif
@@ -0,0 +1,86 @@
+// Packet DDA kernel body, included once per instruction set by raypacket.c
+// with the vector operations below defined for that ISA. Every arithmetic
+// step mirrors CastRayDDA so each lane produces bit-identical results.
+//
+// Required: KERNEL_NAME, KERNEL_TARGET, LANES, VF, VI, VM and the F_/I_/M_ ops.
+
+KERNEL_TARGET static void KERNEL_NAME(const PacketInput* in, int begin, int end, RayHit* hits) {
+    const VF zero = F_SET1(0.0f);
+    const VF one = F_SET1(1.0f);
+    const VF maxDistance = F_SET1(in->maxDistance);
+    const VI minusOne = I_SET1(-1);
+    const VI kindWall = I_SET1(RAY_HIT_WALL);
+
+    for (int base = begin; base < end; base += LANES) {
+        float ox[LANES], oy[LANES], dx[LANES], dy[LANES];
+        for (int lane = 0; lane < LANES; lane++) {
+            // Pad the tail packet with copies of the last ray
+            int i = base + lane < end ? base + lane : end - 1;
+            ox[lane] = in->originX[i * in->originStride];
+            oy[lane] = in->originY[i * in->originStride];
+            dx[lane] = in->dirX[i];
+            dy[lane] = in->dirY[i];
+        }
+        VF originX = F_LOAD(ox), originY = F_LOAD(oy);
+        VF dirX = F_LOAD(dx), dirY = F_LOAD(dy);
+
+        VI mapX = I_FROM_F_TRUNC(originX);
+        VI mapY = I_FROM_F_TRUNC(originY);
+        VF deltaDistX = F_ABS(F_DIV(one, dirX));
+        VF deltaDistY = F_ABS(F_DIV(one, dirY));
+
+        VM negX = M_FLT(dirX, zero);
+        VM negY = M_FLT(dirY, zero);
+        VI stepX = I_BLEND(I_SET1(1), minusOne, negX);
+        VI stepY = I_BLEND(I_SET1(1), minusOne, negY);
+        VF sideDistX = F_BLEND(F_MUL(F_SUB(F_ADD(F_FROM_I(mapX), one), originX), deltaDistX),
+                               F_MUL(F_SUB(originX, F_FROM_I(mapX)), deltaDistX), negX);
+        VF sideDistY = F_BLEND(F_MUL(F_SUB(F_ADD(F_FROM_I(mapY), one), originY), deltaDistY),
+                               F_MUL(F_SUB(originY, F_FROM_I(mapY)), deltaDistY), negY);
+
+        VF hitDistance = maxDistance;
+        VI hitSide = I_SET1(0);
+        VI hitKind = I_SET1(RAY_HIT_NONE);
+        VI hitMapX = minusOne, hitMapY = minusOne;
+        VM active = M_ALL();
+
+        while (M_ANY(active)) {
+            VM takeX = M_FLT(sideDistX, sideDistY);
+            VM stepXMask = M_AND(active, takeX);
+            VM stepYMask = M_ANDNOT(takeX, active);
+            VF distance = F_BLEND(sideDistY, sideDistX, takeX);
+            VI side = I_BLEND(I_SET1(1), I_SET1(0), takeX);
+
+            sideDistX = F_BLEND(sideDistX, F_ADD(sideDistX, deltaDistX), stepXMask);
+            sideDistY = F_BLEND(sideDistY, F_ADD(sideDistY, deltaDistY), stepYMask);
+            mapX = I_BLEND(mapX, I_ADD(mapX, stepX), stepXMask);
+            mapY = I_BLEND(mapY, I_ADD(mapY, stepY), stepYMask);
+
+            // Out of range: the lane keeps the RAY_HIT_NONE defaults
+            VM tooFar = M_AND(active, M_FGE(distance, maxDistance));
+            active = M_ANDNOT(tooFar, active);
+
+            // The map's solid border ends every lane, so no bounds test is needed
+            VM wall = M_WALL(in->map, mapX, mapY, active);
+
+            hitDistance = F_BLEND(hitDistance, distance, wall);
+            hitSide = I_BLEND(hitSide, side, wall);
+            hitKind = I_BLEND(hitKind, kindWall, wall);
+            hitMapX = I_BLEND(hitMapX, mapX, wall);
+            hitMapY = I_BLEND(hitMapY, mapY, wall);
+            active = M_ANDNOT(wall, active);
+        }
+
+        float outDistance[LANES];
+        int32_t outSide[LANES], outKind[LANES], outMapX[LANES], outMapY[LANES];
+        F_STORE(outDistance, hitDistance);
+        I_STORE(outSide, hitSide);
+        I_STORE(outKind, hitKind);
+        I_STORE(outMapX, hitMapX);
+        I_STORE(outMapY, hitMapY);
+        for (int lane = 0; lane < LANES && base + lane < end; lane++) {
+            hits[base + lane] = (RayHit){(RayHitKind)outKind[lane], outDistance[lane], outSide[lane], outMapX[lane],
+                                         outMapY[lane], 0.0f};
+        }
+    }
+}
@@ -0,0 +1,29 @@
+// Clears the per-ISA macros set up before including raypacket_kernel.h
+#undef KERNEL_NAME
+#undef KERNEL_TARGET
+#undef LANES
+#undef VF
+#undef VI
+#undef VM
+#undef F_LOAD
+#undef F_STORE
+#undef F_SET1
+#undef F_ADD
+#undef F_SUB
+#undef F_MUL
+#undef F_DIV
+#undef F_ABS
+#undef F_FROM_I
+#undef F_BLEND
+#undef I_SET1
+#undef I_STORE
+#undef I_ADD
+#undef I_FROM_F_TRUNC
+#undef I_BLEND
+#undef M_ALL
+#undef M_ANY
+#undef M_AND
+#undef M_ANDNOT
+#undef M_FLT
+#undef M_FGE
+#undef M_WALL
@@ -0,0 +1,107 @@
+#include "render.h"
+#include <math.h>
+
+int GetViewRayCount(int screenWidth, bool showDebugMap) {
+    return showDebugMap ? screenWidth / 2 : screenWidth;
+}
+
+int GetViewColumnX(int screenWidth, bool showDebugMap, int ray) {
+    return showDebugMap ? screenWidth / 2 + ray * 2 : ray;
+}
+
+int GetViewColumnWidth(bool showDebugMap) {
+    return showDebugMap ? 2 : 1;
+}
+
+void RenderView(Framebuffer* fb, const RayHit* hits, int numRays, bool showDebugMap) {
+    int columnWidth = GetViewColumnWidth(showDebugMap);
+
+    for (int i = 0; i < numRays; i++) {
+        int columnX = GetViewColumnX(fb->width, showDebugMap, i);
+        const RayHit* hit = &hits[i];
+        if (hit->kind == RAY_HIT_WALL) {
+            // Same float->int truncation as DrawRectangle so both presenters match
+            float wallHeight = (fb->height / hit->distance) * 2;
+            FramebufferFillRect(fb, columnX, (int)(fb->height / 2 - wallHeight / 2), columnWidth, (int)wallHeight,
+                                PIXEL_BLUE);
+        } else if (hit->kind == RAY_HIT_OUTSIDE) {
+            FramebufferFillRect(fb, columnX, 0, columnWidth, fb->height, PIXEL_BLACK);
+        } else {
+            FramebufferFillRect(fb, columnX, 0, columnWidth, fb->height, PIXEL_DARKGRAY);
+        }
+    }
+}
+
+void RenderViewTextured(Framebuffer* fb, const RayHit* hits, int numRays, bool showDebugMap, const Map* map,
+                        const TextureAtlas* atlas) {
+    int columnWidth = GetViewColumnWidth(showDebugMap);
+
+    for (int i = 0; i < numRays; i++) {
+        int columnX = GetViewColumnX(fb->width, showDebugMap, i);
+        const RayHit* hit = &hits[i];
+        // Open columns keep the floor and ceiling drawn underneath
+        if (hit->kind == RAY_HIT_OUTSIDE) FramebufferFillRect(fb, columnX, 0, columnWidth, fb->height, PIXEL_BLACK);
+        if (hit->kind != RAY_HIT_WALL) continue;
+
+        // Same placement as the flat wall, so the two modes line up exactly
+        float wallHeight = (fb->height / hit->distance) * 2;
+        int top = (int)(fb->height / 2 - wallHeight / 2);
+        int height = (int)wallHeight;
+        if (height <= 0) continue;
+        int y0 = top < 0 ? 0 : top;
+        int y1 = top + height > fb->height ? fb->height : top + height;
+
+        // Far walls read from small mips that stay in cache
+        int level = TextureAtlasSelectLevel(wallHeight);
+        int size = TEXTURE_SIZE >> level;
+        int u = (int)(hit->wallX * size);
+        if (u >= size) u = size - 1;
+        const Pixel* texels = TextureAtlasColumn(atlas, MapGetMaterial(map, hit->mapX, hit->mapY), level, u);
+
+        // 16.16 texel step per pixel; side faces are drawn at half brightness
+        uint32_t step = (uint32_t)(((uint64_t)size << 16) / (uint32_t)height);
+        uint32_t v = (uint32_t)(y0 - top) * step;
+        Pixel shadeMask = hit->side ? 0x007F7F7Fu : 0x00FFFFFFu;
+        int shadeShift = hit->side ? 1 : 0;
+        Pixel* dst = fb->pixels + (size_t)y0 * fb->width + columnX;
+        int span = columnX + columnWidth > fb->width ? fb->width - columnX : columnWidth;
+        for (int y = y0; y < y1; y++, v += step, dst += fb->width) {
+            Pixel texel = texels[v >> 16];
+            Pixel color = ((texel >> shadeShift) & shadeMask) | (texel & 0xFF000000u);
+            for (int x = 0; x < span; x++) dst[x] = color;
+        }
+    }
+}
+
+static int ClampWindowOrigin(int center, int size, int span) {
+    if (size <= span) return 0;
+    int origin = center - span / 2;
+    if (origin < 0) return 0;
+    return origin > size - span ? size - span : origin;
+}
+
+MinimapWindow GetMinimapWindow(const Map* map, const Player* player) {
+    MinimapWindow window;
+    window.columns = map->width < MINIMAP_CELLS ? map->width : MINIMAP_CELLS;
+    window.rows = map->height < MINIMAP_CELLS ? map->height : MINIMAP_CELLS;
+    window.originX = ClampWindowOrigin((int)player->pos.x, map->width, window.columns);
+    window.originY = ClampWindowOrigin((int)player->pos.y, map->height, window.rows);
+    return window;
+}
+
+void RenderDebugMap(Framebuffer* fb, const Map* map, const Player* player, const PvsView* pvs) {
+    MinimapWindow window = GetMinimapWindow(map, player);
+    for (int y = 0; y < window.rows; y++) {
+        for (int x = 0; x < window.columns; x++) {
+            int cellX = window.originX + x, cellY = window.originY + y;
+            if (MapIsSolid(map, cellX, cellY) && (!pvs || PvsViewIsVisible(pvs, cellX, cellY))) {
+                FramebufferFillRect(fb, x * MINIMAP_CELL, y * MINIMAP_CELL, MINIMAP_CELL, MINIMAP_CELL, PIXEL_GRAY);
+            }
+        }
+    }
+    float centerX = (player->pos.x - window.originX + PLAYER_OFFSET) * MINIMAP_CELL;
+    float centerY = (player->pos.y - window.originY + PLAYER_OFFSET) * MINIMAP_CELL;
+    FramebufferFillCircle(fb, (int)centerX, (int)centerY, 5, PIXEL_RED);
+    FramebufferDrawLine(fb, (int)centerX, (int)centerY, (int)(centerX + cosf(player->angle * DEG2RAD) * 20),
+                        (int)(centerY + sinf(player->angle * DEG2RAD) * 20), PIXEL_RED);
+}
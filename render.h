@@ -0,0 +1,33 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "framebuffer.h"
+#include "pvs.h"
+#include "raycast.h"
+#include "texture.h"
+
+#define MINIMAP_CELL 32
+#define MINIMAP_CELLS 12 // Largest map window shown; bigger maps scroll with the player
+
+typedef struct {
+    int originX; // First map cell shown
+    int originY;
+    int columns;
+    int rows;
+} MinimapWindow;
+
+// With the debug map on, the 3D view takes the right half in 2-pixel columns
+int GetViewRayCount(int screenWidth, bool showDebugMap);
+int GetViewColumnX(int screenWidth, bool showDebugMap, int ray);
+int GetViewColumnWidth(bool showDebugMap);
+
+void RenderView(Framebuffer* fb, const RayHit* hits, int numRays, bool showDebugMap);
+// Walls sampled from the atlas by the material of the struck cell, drawn over
+// RenderFloorCeiling output
+void RenderViewTextured(Framebuffer* fb, const RayHit* hits, int numRays, bool showDebugMap, const Map* map,
+                        const TextureAtlas* atlas);
+MinimapWindow GetMinimapWindow(const Map* map, const Player* player);
+// With a PVS view, walls the player's cell cannot see are left out
+void RenderDebugMap(Framebuffer* fb, const Map* map, const Player* player, const PvsView* pvs);
+
+#endif
@@ -0,0 +1,225 @@
+#include "sim.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Ticks the simulation may fall behind before it stops catching up
+#define SIM_MAX_LAG_TICKS 8
+
+struct Simulation {
+    InputQueue input;
+    Map map; // Simulation-side occupancy
+    SimSnapshot state;
+    SimEdit edits[SIM_EDIT_RING];
+    _Alignas(64) atomic_uint editsApplied; // Written by the renderer
+    // Double-buffered snapshots, each guarded by a sequence that is odd while it is written
+    SimSnapshot snapshots[2];
+    atomic_uint sequences[2];
+    atomic_int latest;
+    // Signalled on every publish, for renderers waiting on the next tick
+    pthread_mutex_t tickLock;
+    pthread_cond_t ticked;
+    atomic_bool stop;
+    int tickRate;
+    pthread_t thread;
+};
+
+bool InputQueuePush(InputQueue* queue, InputEvent event) {
+    unsigned head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head - tail == INPUT_QUEUE_SIZE) return false;
+    queue->events[head & (INPUT_QUEUE_SIZE - 1)] = event;
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool InputQueuePop(InputQueue* queue, InputEvent* event) {
+    unsigned tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (head == tail) return false;
+    *event = queue->events[tail & (INPUT_QUEUE_SIZE - 1)];
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+static void PublishSnapshot(Simulation* sim) {
+    int index = 1 - atomic_load_explicit(&sim->latest, memory_order_relaxed);
+    unsigned sequence = atomic_load_explicit(&sim->sequences[index], memory_order_relaxed);
+    atomic_store_explicit(&sim->sequences[index], sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    sim->snapshots[index] = sim->state;
+    atomic_store_explicit(&sim->sequences[index], sequence + 2, memory_order_release);
+    pthread_mutex_lock(&sim->tickLock);
+    atomic_store_explicit(&sim->latest, index, memory_order_release);
+    pthread_cond_broadcast(&sim->ticked);
+    pthread_mutex_unlock(&sim->tickLock);
+}
+
+static void ToggleDoor(Simulation* sim) {
+    float forwardX = 0.0f, forwardY = 0.0f, backwardX = 0.0f, backwardY = 0.0f;
+    const Player* player = &sim->state.player;
+    GetMovementDirections(player->angle, &forwardX, &forwardY, &backwardX, &backwardY);
+    int x = (int)(player->pos.x + forwardX * CELL_SIZE);
+    int y = (int)(player->pos.y + forwardY * CELL_SIZE);
+    if (x < 0 || y < 0 || x >= sim->map.width || y >= sim->map.height) return;
+
+    // A renderer that falls a whole ring behind loses the edit rather than stalling the tick
+    uint32_t count = sim->state.editCount;
+    if (count - atomic_load_explicit(&sim->editsApplied, memory_order_acquire) == SIM_EDIT_RING) {
+        fprintf(stderr, "sim: edit ring full, dropping edit\n");
+        return;
+    }
+    bool solid = !MapIsSolid(&sim->map, x, y);
+    MapSetSolid(&sim->map, x, y, solid);
+    sim->edits[count & (SIM_EDIT_RING - 1)] = (SimEdit){x, y, solid};
+    sim->state.editCount = count + 1;
+}
+
+static void ApplyInput(Simulation* sim, InputAction action) {
+    SimSnapshot* state = &sim->state;
+    switch (action) {
+    case INPUT_FORWARD:
+        StepPlayer(&state->player, &sim->map, true);
+        break;
+    case INPUT_BACKWARD:
+        StepPlayer(&state->player, &sim->map, false);
+        break;
+    case INPUT_TURN_LEFT:
+        TurnPlayer(&state->player, true);
+        break;
+    case INPUT_TURN_RIGHT:
+        TurnPlayer(&state->player, false);
+        break;
+    case INPUT_TOGGLE_DOOR:
+        ToggleDoor(sim);
+        break;
+    case INPUT_TOGGLE_MAP:
+        state->showDebugMap = !state->showDebugMap;
+        break;
+    case INPUT_NEXT_CASTER:
+        state->caster = (CasterKind)((state->caster + 1) % CASTER_COUNT);
+        break;
+    case INPUT_TOGGLE_TEXTURES:
+        state->textured = !state->textured;
+        break;
+    }
+}
+
+static void AddNanoseconds(struct timespec* time, long nanoseconds) {
+    time->tv_nsec += nanoseconds;
+    while (time->tv_nsec >= 1000000000L) {
+        time->tv_nsec -= 1000000000L;
+        time->tv_sec++;
+    }
+}
+
+static void* SimulationMain(void* arg) {
+    Simulation* sim = arg;
+    long tickNanoseconds = 1000000000L / sim->tickRate;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (!atomic_load_explicit(&sim->stop, memory_order_acquire)) {
+        AddNanoseconds(&next, tickNanoseconds);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) continue;
+
+        InputEvent event;
+        while (InputQueuePop(&sim->input, &event)) ApplyInput(sim, (InputAction)event.action);
+        sim->state.tick++;
+        PublishSnapshot(sim);
+
+        // After a long stall, tick from now instead of bursting through the missed ticks
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double lag = (now.tv_sec - next.tv_sec) + (now.tv_nsec - next.tv_nsec) * 1e-9;
+        if (lag > SIM_MAX_LAG_TICKS * tickNanoseconds * 1e-9) next = now;
+    }
+    return NULL;
+}
+
+Simulation* SimulationStart(const Map* map, const SimSnapshot* initial, int tickRate) {
+    Simulation* sim = calloc(1, sizeof(Simulation));
+    if (!sim) return NULL;
+    if (!MapInit(&sim->map, map->width, map->height, false)) {
+        free(sim);
+        return NULL;
+    }
+    memcpy(sim->map.bits, map->bits, sizeof(uint64_t) * (size_t)(map->height + 2) * map->stride);
+    sim->tickRate = tickRate > 0 ? tickRate : SIM_DEFAULT_TICK_RATE;
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&sim->ticked, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&sim->tickLock, NULL);
+    sim->state = *initial;
+    sim->state.tick = 0;
+    sim->state.editCount = 0;
+    PublishSnapshot(sim);
+
+    if (pthread_create(&sim->thread, NULL, SimulationMain, sim) != 0) {
+        pthread_cond_destroy(&sim->ticked);
+        pthread_mutex_destroy(&sim->tickLock);
+        MapFree(&sim->map);
+        free(sim);
+        return NULL;
+    }
+    return sim;
+}
+
+void SimulationStop(Simulation* sim) {
+    if (!sim) return;
+    atomic_store_explicit(&sim->stop, true, memory_order_release);
+    pthread_join(sim->thread, NULL);
+    pthread_cond_destroy(&sim->ticked);
+    pthread_mutex_destroy(&sim->tickLock);
+    MapFree(&sim->map);
+    free(sim);
+}
+
+bool SimulationPostInput(Simulation* sim, InputAction action) {
+    return InputQueuePush(&sim->input, (InputEvent){(uint8_t)action});
+}
+
+// Seqlock read: retries while the writer has the buffer open or reopened it mid-copy
+void SimulationGetSnapshot(Simulation* sim, SimSnapshot* snapshot) {
+    for (;;) {
+        int index = atomic_load_explicit(&sim->latest, memory_order_acquire);
+        unsigned before = atomic_load_explicit(&sim->sequences[index], memory_order_acquire);
+        if (before & 1) continue;
+        *snapshot = sim->snapshots[index];
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&sim->sequences[index], memory_order_relaxed) == before) return;
+    }
+}
+
+static uint32_t GetLatestTick(Simulation* sim) {
+    SimSnapshot snapshot;
+    SimulationGetSnapshot(sim, &snapshot);
+    return snapshot.tick;
+}
+
+bool SimulationWaitForTick(Simulation* sim, uint32_t tick, double timeoutSeconds) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    AddNanoseconds(&deadline, (long)(timeoutSeconds * 1e9));
+    pthread_mutex_lock(&sim->tickLock);
+    int result = 0;
+    while (GetLatestTick(sim) == tick && result != ETIMEDOUT) {
+        result = pthread_cond_timedwait(&sim->ticked, &sim->tickLock, &deadline);
+    }
+    bool newer = GetLatestTick(sim) != tick;
+    pthread_mutex_unlock(&sim->tickLock);
+    return newer;
+}
+
+SimEdit SimulationGetEdit(const Simulation* sim, uint32_t index) {
+    return sim->edits[index & (SIM_EDIT_RING - 1)];
+}
+
+void SimulationEditsApplied(Simulation* sim, uint32_t editCount) {
+    atomic_store_explicit(&sim->editsApplied, editCount, memory_order_release);
+}
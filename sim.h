@@ -0,0 +1,75 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "raycast.h"
+#include <stdatomic.h>
+
+// Player simulation on its own thread at a fixed tick. Input arrives through
+// a lock-free single-producer/single-consumer queue, and every tick publishes
+// an immutable snapshot that renderers copy out of a double buffer. The
+// simulation keeps its own copy of the occupancy for collisions; the cells it
+// changes are handed to renderers through an edit ring so they can patch
+// their own level.
+#define INPUT_QUEUE_SIZE 256 // Power of two
+#define SIM_EDIT_RING 4096 // Power of two
+#define SIM_DEFAULT_TICK_RATE 60
+
+typedef enum {
+    INPUT_FORWARD,
+    INPUT_BACKWARD,
+    INPUT_TURN_LEFT,
+    INPUT_TURN_RIGHT,
+    INPUT_TOGGLE_DOOR, // Opens or closes the cell in front
+    INPUT_TOGGLE_MAP,
+    INPUT_NEXT_CASTER,
+    INPUT_TOGGLE_TEXTURES,
+} InputAction;
+
+typedef struct {
+    uint8_t action;
+} InputEvent;
+
+// Head and tail sit on their own cache lines; each is written by one side only
+typedef struct {
+    _Alignas(64) atomic_uint head; // Next slot the producer writes
+    _Alignas(64) atomic_uint tail; // Next slot the consumer reads
+    InputEvent events[INPUT_QUEUE_SIZE];
+} InputQueue;
+
+// Fails when the queue is full
+bool InputQueuePush(InputQueue* queue, InputEvent event);
+// Fails when the queue is empty
+bool InputQueuePop(InputQueue* queue, InputEvent* event);
+
+typedef struct {
+    Player player;
+    bool showDebugMap;
+    bool textured;
+    CasterKind caster;
+    uint32_t tick;
+    uint32_t editCount; // Edits 0..editCount - 1 are part of this state
+} SimSnapshot;
+
+typedef struct {
+    int x;
+    int y;
+    bool solid;
+} SimEdit;
+
+typedef struct Simulation Simulation;
+
+// Copies map; initial is published as tick 0
+Simulation* SimulationStart(const Map* map, const SimSnapshot* initial, int tickRate);
+void SimulationStop(Simulation* sim);
+// Producer side of the input queue: call from one thread only. Fails when the queue is full.
+bool SimulationPostInput(Simulation* sim, InputAction action);
+void SimulationGetSnapshot(Simulation* sim, SimSnapshot* snapshot);
+// Blocks until a snapshot other than tick is published or the timeout passes;
+// returns whether one was
+bool SimulationWaitForTick(Simulation* sim, uint32_t tick, double timeoutSeconds);
+// Reads edit index of a snapshot's edits; call SimulationEditsApplied once they are
+// in so the ring slots can be reused
+SimEdit SimulationGetEdit(const Simulation* sim, uint32_t index);
+void SimulationEditsApplied(Simulation* sim, uint32_t editCount);
+
+#endif
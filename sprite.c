@@ -0,0 +1,237 @@
+#include "sprite.h"
+#include "render.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Simple shapes standing on the bottom edge of the image
+static Pixel GenerateSpriteTexel(SpriteKind kind, int x, int y) {
+    float cx = x - SPRITE_SIZE / 2 + 0.5f;
+    switch (kind) {
+    case SPRITE_NPC: {
+        float headY = y - 7.5f;
+        if (cx * cx + headY * headY < 25.0f) return PIXEL_RGBA(240, 200, 160, 255);
+        float bodyY = (y - 22.0f) / 10.0f;
+        if (y >= 12 && (cx / 8.0f) * (cx / 8.0f) + bodyY * bodyY < 1.0f) return PIXEL_RGBA(40, 160, 60, 255);
+        return 0;
+    }
+    case SPRITE_PICKUP: {
+        float d = fabsf(cx) + fabsf(y - 24.0f);
+        if (d < 7.0f) return d < 3.0f ? PIXEL_RGBA(255, 255, 200, 255) : PIXEL_RGBA(250, 200, 30, 255);
+        return 0;
+    }
+    default: // SPRITE_BARREL
+        if (fabsf(cx) < 9.0f && y >= 10) {
+            bool band = y == 14 || y == 15 || y == 26 || y == 27;
+            return band ? PIXEL_RGBA(70, 70, 80, 255) : PIXEL_RGBA(140, 80 + (int)fabsf(cx) * 2, 30, 255);
+        }
+        return 0;
+    }
+}
+
+bool SpriteSetInit(SpriteSet* set, const Map* map) {
+    *set = (SpriteSet){.mapWidth = map->width, .mapHeight = map->height};
+    set->blocksWide = (map->width + (1 << SPRITE_BLOCK_SHIFT) - 1) >> SPRITE_BLOCK_SHIFT;
+    int blocksHigh = (map->height + (1 << SPRITE_BLOCK_SHIFT) - 1) >> SPRITE_BLOCK_SHIFT;
+    size_t blocks = (size_t)set->blocksWide * blocksHigh;
+    set->blockHead = malloc(sizeof(int) * blocks);
+    set->sheet = malloc(sizeof(Pixel) * SPRITE_KINDS * SPRITE_SIZE * SPRITE_SIZE);
+    if (!set->blockHead || !set->sheet) {
+        SpriteSetFree(set);
+        return false;
+    }
+    memset(set->blockHead, 0xFF, sizeof(int) * blocks);
+
+    for (int kind = 0; kind < SPRITE_KINDS; kind++) {
+        Pixel* image = set->sheet + kind * SPRITE_SIZE * SPRITE_SIZE;
+        for (int u = 0; u < SPRITE_SIZE; u++) {
+            for (int v = 0; v < SPRITE_SIZE; v++) image[u * SPRITE_SIZE + v] = GenerateSpriteTexel(kind, u, v);
+        }
+    }
+    return true;
+}
+
+void SpriteSetFree(SpriteSet* set) {
+    free(set->sprites);
+    free(set->blockHead);
+    free(set->visible);
+    free(set->sheet);
+    *set = (SpriteSet){0};
+}
+
+bool SpriteSetAdd(SpriteSet* set, float x, float y, SpriteKind kind) {
+    int cellX = (int)x;
+    int cellY = (int)y;
+    if (x < 0 || y < 0 || cellX >= set->mapWidth || cellY >= set->mapHeight) return false;
+
+    if (set->count == set->capacity) {
+        int capacity = set->capacity ? set->capacity * 2 : 64;
+        Sprite* sprites = realloc(set->sprites, sizeof(Sprite) * capacity);
+        if (!sprites) return false;
+        set->sprites = sprites;
+        SpriteView* visible = realloc(set->visible, sizeof(SpriteView) * capacity);
+        if (!visible) return false;
+        set->visible = visible;
+        set->capacity = capacity;
+    }
+
+    int block = (cellY >> SPRITE_BLOCK_SHIFT) * set->blocksWide + (cellX >> SPRITE_BLOCK_SHIFT);
+    set->sprites[set->count] = (Sprite){x, y, kind, set->blockHead[block]};
+    set->blockHead[block] = set->count++;
+    return true;
+}
+
+bool SpriteSetScatter(SpriteSet* set, const Map* map, int count, uint32_t seed) {
+    uint32_t state = seed ? seed : 1;
+    for (int placed = 0, attempts = 0; placed < count && attempts < count * 16; attempts++) {
+        state ^= state << 13, state ^= state >> 17, state ^= state << 5;
+        int x = state % map->width;
+        state ^= state << 13, state ^= state >> 17, state ^= state << 5;
+        int y = state % map->height;
+        if (MapIsSolid(map, x, y)) continue;
+        state ^= state << 13, state ^= state >> 17, state ^= state << 5;
+        float jitterX = ((state & 0xFF) / 255.0f - 0.5f) * 0.6f;
+        float jitterY = (((state >> 8) & 0xFF) / 255.0f - 0.5f) * 0.6f;
+        if (!SpriteSetAdd(set, x + 0.5f + jitterX, y + 0.5f + jitterY, (SpriteKind)((state >> 16) % SPRITE_KINDS))) {
+            return false;
+        }
+        placed++;
+    }
+    return true;
+}
+
+// Columns a sprite covers at its place in view; false when none do
+static bool GetSpriteColumns(const RayTable* table, float depth, float lateral, float* leftAngle, float* halfAngle,
+                             int* first, int* last) {
+    if (depth < 0.05f) return false;
+    // Columns are equiangular, so place the sprite by angle rather than by tangent
+    float fov = table->fov * DEG2RAD;
+    float angleStep = fov / table->numRays;
+    float angle = atan2f(lateral, depth);
+    *halfAngle = atanf(SPRITE_WORLD_SIZE * 0.5f / depth);
+    *leftAngle = angle - *halfAngle;
+    *first = (int)ceilf((*leftAngle + fov / 2) / angleStep);
+    *last = (int)floorf((angle + *halfAngle + fov / 2) / angleStep);
+    if (*first < 0) *first = 0;
+    if (*last >= table->numRays) *last = table->numRays - 1;
+    return *first <= *last;
+}
+
+// A billboard reaches half its width past its foot point, into up to four
+// cells; cells past the map edge are outside every set, so they always count
+static bool MayBeSeen(const SpriteSet* set, const PvsView* pvs, const Sprite* sprite) {
+    float reach = SPRITE_WORLD_SIZE * 0.5f;
+    int x0 = (int)floorf(sprite->x - reach), x1 = (int)floorf(sprite->x + reach);
+    int y0 = (int)floorf(sprite->y - reach), y1 = (int)floorf(sprite->y + reach);
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            bool inside = x >= 0 && y >= 0 && x < set->mapWidth && y < set->mapHeight;
+            if (!inside || PvsViewMaySee(pvs, x, y)) return true;
+        }
+    }
+    return false;
+}
+
+static int CompareFarFirst(const void* a, const void* b) {
+    float da = ((const SpriteView*)a)->depth;
+    float db = ((const SpriteView*)b)->depth;
+    return (da < db) - (da > db);
+}
+
+void SpriteSetCollectVisible(SpriteSet* set, const Player* player, const RayTable* table, const RayHit* hits,
+                             const PvsView* pvs) {
+    float originX = player->pos.x + PLAYER_OFFSET;
+    float originY = player->pos.y + PLAYER_OFFSET;
+    float cosA = cosf(player->angle * DEG2RAD);
+    float sinA = sinf(player->angle * DEG2RAD);
+    set->visibleCount = 0;
+    if (set->count == 0 || table->numRays == 0) return;
+
+    // Every hit lies in the wedge between the outer columns, out to the
+    // farthest depth; its bounding box, widened by a sprite, picks the blocks
+    float far = 0.0f;
+    for (int i = 0; i < table->numRays; i++) {
+        if (hits[i].distance > far) far = hits[i].distance;
+    }
+    float minX = originX, maxX = originX, minY = originY, maxY = originY;
+    float edges[2] = {table->offset[0], table->offset[table->numRays - 1]};
+    for (int e = 0; e < 2; e++) {
+        float x = originX + far * (cosA - sinA * edges[e]);
+        float y = originY + far * (sinA + cosA * edges[e]);
+        minX = fminf(minX, x), maxX = fmaxf(maxX, x);
+        minY = fminf(minY, y), maxY = fmaxf(maxY, y);
+    }
+    float margin = SPRITE_WORLD_SIZE * 0.5f;
+    int blockX0 = (int)fmaxf(minX - margin, 0.0f) >> SPRITE_BLOCK_SHIFT;
+    int blockY0 = (int)fmaxf(minY - margin, 0.0f) >> SPRITE_BLOCK_SHIFT;
+    int blockX1 = (int)fminf(maxX + margin, (float)(set->mapWidth - 1)) >> SPRITE_BLOCK_SHIFT;
+    int blockY1 = (int)fminf(maxY + margin, (float)(set->mapHeight - 1)) >> SPRITE_BLOCK_SHIFT;
+
+    for (int blockY = blockY0; blockY <= blockY1; blockY++) {
+        for (int blockX = blockX0; blockX <= blockX1; blockX++) {
+            for (int i = set->blockHead[blockY * set->blocksWide + blockX]; i >= 0; i = set->sprites[i].next) {
+                const Sprite* sprite = &set->sprites[i];
+                if (pvs && !MayBeSeen(set, pvs, sprite)) continue;
+                float depth = (sprite->x - originX) * cosA + (sprite->y - originY) * sinA;
+                float lateral = -(sprite->x - originX) * sinA + (sprite->y - originY) * cosA;
+                float leftAngle, halfAngle;
+                int first, last;
+                if (!GetSpriteColumns(table, depth, lateral, &leftAngle, &halfAngle, &first, &last)) continue;
+                // Drawn when any column it covers reaches past it, the same test RenderSprites makes
+                int c = first;
+                while (c <= last && depth >= hits[c].distance) c++;
+                if (c <= last) set->visible[set->visibleCount++] = (SpriteView){i, depth};
+            }
+        }
+    }
+
+    qsort(set->visible, set->visibleCount, sizeof(SpriteView), CompareFarFirst);
+}
+
+void RenderSprites(Framebuffer* fb, const SpriteSet* set, const Player* player, const RayTable* table,
+                   const RayHit* hits, bool showDebugMap) {
+    float originX = player->pos.x + PLAYER_OFFSET;
+    float originY = player->pos.y + PLAYER_OFFSET;
+    float cosA = cosf(player->angle * DEG2RAD);
+    float sinA = sinf(player->angle * DEG2RAD);
+    float fov = table->fov * DEG2RAD;
+    float angleStep = fov / table->numRays;
+    int columnWidth = GetViewColumnWidth(showDebugMap);
+
+    for (int s = 0; s < set->visibleCount; s++) {
+        const Sprite* sprite = &set->sprites[set->visible[s].index];
+        float depth = set->visible[s].depth;
+        float lateral = -(sprite->x - originX) * sinA + (sprite->y - originY) * cosA;
+        float leftAngle, halfAngle;
+        int firstColumn, lastColumn;
+        if (!GetSpriteColumns(table, depth, lateral, &leftAngle, &halfAngle, &firstColumn, &lastColumn)) continue;
+
+        // Same scale as walls (2 * height / depth pixels per unit), standing on the floor line
+        float bottom = fb->height / 2 + fb->height / depth;
+        int height = (int)(SPRITE_WORLD_SIZE * 2 * fb->height / depth);
+        if (height <= 0) continue;
+        int top = (int)bottom - height;
+        int y0 = top < 0 ? 0 : top;
+        int y1 = top + height > fb->height ? fb->height : top + height;
+        uint32_t step = (uint32_t)(((uint64_t)SPRITE_SIZE << 16) / (uint32_t)height);
+        const Pixel* image = set->sheet + sprite->kind * SPRITE_SIZE * SPRITE_SIZE;
+
+        for (int c = firstColumn; c <= lastColumn; c++) {
+            if (depth >= hits[c].distance) continue;
+            int u = (int)((-fov / 2 + c * angleStep - leftAngle) / (2 * halfAngle) * SPRITE_SIZE);
+            if (u < 0 || u >= SPRITE_SIZE) continue;
+            const Pixel* texels = image + u * SPRITE_SIZE;
+            int columnX = GetViewColumnX(fb->width, showDebugMap, c);
+            int span = columnX + columnWidth > fb->width ? fb->width - columnX : columnWidth;
+            if (span <= 0) continue;
+
+            Pixel* dst = fb->pixels + (size_t)y0 * fb->width + columnX;
+            uint32_t v = (uint32_t)(y0 - top) * step;
+            for (int y = y0; y < y1; y++, v += step, dst += fb->width) {
+                Pixel texel = texels[v >> 16];
+                if (!(texel >> 24)) continue;
+                for (int x = 0; x < span; x++) dst[x] = texel;
+            }
+        }
+    }
+}
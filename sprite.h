@@ -0,0 +1,57 @@
+#ifndef SPRITE_H
+#define SPRITE_H
+
+#include "framebuffer.h"
+#include "raycast.h"
+
+// Billboard entities, indexed by 16x16 cell block. Culling reuses the hit
+// buffer of the cast: only blocks under the view wedge are looked at, and a
+// sprite there is kept when a column it covers sees past it.
+#define SPRITE_BLOCK_SHIFT 4
+#define SPRITE_SIZE 32
+#define SPRITE_KINDS 3
+#define SPRITE_WORLD_SIZE 0.6f // Width and height in map units
+
+typedef enum { SPRITE_NPC, SPRITE_PICKUP, SPRITE_BARREL } SpriteKind;
+
+typedef struct {
+    float x; // World position of the sprite's foot point
+    float y;
+    SpriteKind kind;
+    int next; // Next sprite in the same block, -1 ends the chain
+} Sprite;
+
+typedef struct {
+    int index;
+    float depth; // Distance along the view direction
+} SpriteView;
+
+typedef struct {
+    int count;
+    int capacity;
+    Sprite* sprites;
+    int mapWidth;
+    int mapHeight;
+    int blocksWide;
+    int* blockHead; // First sprite per block, -1 if none
+    SpriteView* visible; // Collected by the last SpriteSetCollectVisible
+    int visibleCount;
+    Pixel* sheet; // SPRITE_KINDS column-major images, alpha 0 = transparent
+} SpriteSet;
+
+bool SpriteSetInit(SpriteSet* set, const Map* map);
+void SpriteSetFree(SpriteSet* set);
+bool SpriteSetAdd(SpriteSet* set, float x, float y, SpriteKind kind);
+// Drops count sprites on random free cells; the same seed gives the same layout
+bool SpriteSetScatter(SpriteSet* set, const Map* map, int count, uint32_t seed);
+
+// Collects the sprites that some column's hit lies beyond, sorted far to
+// near; the grid is not walked again. With pvs (decoded for the player's
+// cell, may be NULL) sprites in cells the set rules out are skipped first.
+void SpriteSetCollectVisible(SpriteSet* set, const Player* player, const RayTable* table, const RayHit* hits,
+                             const PvsView* pvs);
+// Draws the collected sprites, clipped per column against the hit distances
+void RenderSprites(Framebuffer* fb, const SpriteSet* set, const Player* player, const RayTable* table,
+                   const RayHit* hits, bool showDebugMap);
+
+#endif
@@ -0,0 +1,126 @@
+#include "temporal.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void FreeBuffers(TemporalCache* cache) {
+    free(cache->columns[0]);
+    free(cache->dirX);
+    cache->columns[0] = cache->columns[1] = NULL;
+    cache->dirX = cache->dirY = cache->columnCos = NULL;
+    cache->valid = false;
+}
+
+static bool EnsureBuffers(TemporalCache* cache, const RayTable* table) {
+    if (cache->dirX && cache->numRays == table->numRays && cache->fov == table->fov) return true;
+    FreeBuffers(cache);
+    int n = table->numRays;
+    cache->columns[0] = malloc(sizeof(RayHit) * n * 2);
+    cache->dirX = malloc(sizeof(float) * n * 3);
+    if (!cache->columns[0] || !cache->dirX) {
+        FreeBuffers(cache);
+        return false;
+    }
+    cache->columns[1] = cache->columns[0] + n;
+    cache->dirY = cache->dirX + n;
+    cache->columnCos = cache->dirX + n * 2;
+    for (int i = 0; i < n; i++) cache->columnCos[i] = 1.0f / sqrtf(1.0f + table->offset[i] * table->offset[i]);
+    cache->numRays = n;
+    cache->fov = table->fov;
+    return true;
+}
+
+void TemporalCacheFree(TemporalCache* cache) {
+    FreeBuffers(cache);
+    *cache = (TemporalCache){0};
+}
+
+static void CastTask(void* context, int begin, int end) {
+    CastColumns(context, begin, end);
+}
+
+// Casts columns [begin, end) of the current frame along unit directions. The
+// reach covers the widest column, so a stored hit stays valid in any column.
+static void CastRange(TemporalCache* cache, const Level* level, int begin, int end, ThreadPool* pool) {
+    float rayAngleStep = cache->fov / (float)cache->numRays;
+    for (int i = begin; i < end; i++) {
+        double angle = (cache->heading + (-(cache->fov / 2.0f) + i * rayAngleStep)) * DEG2RAD;
+        cache->dirX[i] = (float)cos(angle);
+        cache->dirY[i] = (float)sin(angle);
+    }
+    CastJob job = {.level = level,
+                   .originX = cache->originX,
+                   .originY = cache->originY,
+                   .dirX = cache->dirX + begin,
+                   .dirY = cache->dirY + begin,
+                   .caster = cache->caster,
+                   .maxDistance = cache->maxDistance / cosf(cache->fov / 2.0f * DEG2RAD),
+                   .hits = cache->columns[cache->current] + begin};
+    ThreadPoolRun(pool, CastTask, &job, end - begin);
+    cache->columnsCast += end - begin;
+}
+
+static double WrapDegrees(double angle) {
+    angle = fmod(angle, 360.0);
+    return angle < 0.0 ? angle + 360.0 : angle;
+}
+
+float TemporalCacheCast(TemporalCache* cache, const Level* level, const Player* player, const RayTable* table,
+                        CasterKind caster, float maxDistance, RayHit* hits, ThreadPool* pool) {
+    // The fixed-point caster keeps its own directions and stays deterministic
+    if (caster == CASTER_FIXED || !EnsureBuffers(cache, table)) {
+        CastView(level, player, table, caster, maxDistance, hits, pool);
+        return player->angle;
+    }
+    int n = cache->numRays;
+    double step = (double)cache->fov / n;
+    float originX = player->pos.x + PLAYER_OFFSET;
+    float originY = player->pos.y + PLAYER_OFFSET;
+    // Whole column steps from the previous heading, the short way round
+    int shift = (int)lround(remainder(player->angle - cache->heading, 360.0) / step);
+
+    if (cache->valid && originX == cache->originX && originY == cache->originY &&
+        level->editCount == cache->editCount && caster == cache->caster && maxDistance == cache->maxDistance &&
+        abs(shift) < n) {
+        // Column i now looks where column i + shift did
+        const RayHit* previous = cache->columns[cache->current];
+        cache->current ^= 1;
+        int keepBegin = shift < 0 ? -shift : 0;
+        int keepEnd = shift > 0 ? n - shift : n;
+        memcpy(cache->columns[cache->current] + keepBegin, previous + keepBegin + shift,
+               sizeof(RayHit) * (keepEnd - keepBegin));
+        cache->heading = WrapDegrees(cache->heading + shift * step);
+        if (keepBegin > 0) CastRange(cache, level, 0, keepBegin, pool);
+        if (keepEnd < n) CastRange(cache, level, keepEnd, n, pool);
+        cache->framesReused++;
+        cache->columnsReused += keepEnd - keepBegin;
+    } else {
+        cache->heading = WrapDegrees(round(player->angle / step) * step);
+        cache->originX = originX;
+        cache->originY = originY;
+        cache->editCount = level->editCount;
+        cache->caster = caster;
+        cache->maxDistance = maxDistance;
+        cache->valid = true;
+        CastRange(cache, level, 0, n, pool);
+    }
+
+    // Back to perpendicular distances, cut at the view distance like CastView
+    const RayHit* columns = cache->columns[cache->current];
+    for (int i = 0; i < n; i++) {
+        RayHit hit = columns[i];
+        hit.distance = hit.kind == RAY_HIT_NONE ? maxDistance : hit.distance * cache->columnCos[i];
+        if (hit.kind != RAY_HIT_NONE && hit.distance >= maxDistance) {
+            hit = (RayHit){RAY_HIT_NONE, maxDistance, 0, -1, -1, 0.0f};
+        }
+        hits[i] = hit;
+    }
+    return (float)cache->heading;
+}
+
+void TemporalCachePrintStats(const TemporalCache* cache) {
+    long total = cache->columnsReused + cache->columnsCast;
+    printf("temporal reuse: %ld frames shifted, %ld/%ld columns reused (%.1f%%)\n", cache->framesReused,
+           cache->columnsReused, total, total > 0 ? 100.0 * cache->columnsReused / total : 0.0);
+}
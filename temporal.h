@@ -0,0 +1,40 @@
+#ifndef TEMPORAL_H
+#define TEMPORAL_H
+
+#include "raycast.h"
+
+// Continuous rotation in place re-casts mostly the same world directions
+// every frame. Columns are equiangular (see RayTableInit), so once the
+// heading is snapped to the column step a turn is a whole-column shift of
+// the previous frame: only the columns exposed at the leading edge are cast.
+// Any translation, level edit or cast setting change falls back to a full
+// cast. A zeroed cache is ready to use.
+typedef struct {
+    int numRays;
+    float fov;
+    RayHit* columns[2]; // Current and previous frame, distances along unit world directions
+    float* dirX; // Unit world directions of the current frame
+    float* dirY;
+    float* columnCos; // Cosine of each column's angle off the view axis
+    int current;
+    bool valid;
+    double heading; // Snapped heading of the current frame, degrees in [0, 360)
+    float originX;
+    float originY;
+    uint32_t editCount;
+    CasterKind caster;
+    float maxDistance;
+    long framesReused; // Frames that shifted the previous one
+    long columnsReused;
+    long columnsCast;
+} TemporalCache;
+
+void TemporalCacheFree(TemporalCache* cache);
+// CastView for the player's heading snapped to the nearest column step.
+// Returns the heading the view was cast at; draw the floor and sprites at it
+// too so they line up with the walls.
+float TemporalCacheCast(TemporalCache* cache, const Level* level, const Player* player, const RayTable* table,
+                        CasterKind caster, float maxDistance, RayHit* hits, ThreadPool* pool);
+void TemporalCachePrintStats(const TemporalCache* cache);
+
+#endif
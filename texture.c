@@ -0,0 +1,113 @@
+#include "texture.h"
+#include <stdlib.h>
+
+static uint32_t HashTexel(uint32_t material, uint32_t x, uint32_t y) {
+    uint32_t h = material * 0x9E3779B9u ^ x * 0x85EBCA6Bu ^ y * 0xC2B2AE35u;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return h;
+}
+
+static Pixel Shade(int r, int g, int b, int amount) {
+    r += amount;
+    g += amount;
+    b += amount;
+    r = r < 0 ? 0 : (r > 255 ? 255 : r);
+    g = g < 0 ? 0 : (g > 255 ? 255 : g);
+    b = b < 0 ? 0 : (b > 255 ? 255 : b);
+    return PIXEL_RGBA(r, g, b, 255);
+}
+
+// Base-level texel (x across the wall, y down) for each material
+static Pixel GenerateTexel(int material, int x, int y) {
+    int noise = (int)(HashTexel(material, x, y) & 31) - 16;
+    switch (material) {
+    case 1: { // Red brick
+        int row = y / 8;
+        int offset = (row & 1) * 8;
+        bool mortar = y % 8 == 0 || (x + offset) % 16 == 0;
+        return mortar ? Shade(150, 150, 140, noise / 2) : Shade(160, 60, 40, noise);
+    }
+    case 2: { // Grey stone blocks
+        bool seam = y % 16 == 0 || (x + (y / 16 & 1) * 11) % 22 == 0;
+        return seam ? Shade(60, 60, 60, noise / 2) : Shade(125, 125, 120, noise * 2);
+    }
+    case 3: // Wooden planks
+        return x % 16 == 0 ? Shade(60, 35, 15, 0) : Shade(130, 85, 45, noise + ((x * 7 + y / 3) % 9) * 2);
+    case 4: // Blue tiles
+        return (x % 16 == 0 || y % 16 == 0) ? Shade(220, 220, 220, noise / 4)
+                                            : Shade(30, 80 + ((x / 16 + y / 16) & 1) * 40, 180, noise / 2);
+    case 5: // Mossy stone
+        return (HashTexel(material, x / 4, y / 4) & 3) == 0 ? Shade(50, 120, 40, noise) : Shade(100, 105, 95, noise);
+    case 6: { // Metal panel with rivets
+        int px = x % 32;
+        int py = y % 32;
+        bool rivet = (px == 3 || px == 28) && (py == 3 || py == 28);
+        bool edge = px == 0 || py == 0;
+        return rivet ? Shade(220, 220, 230, 0) : (edge ? Shade(50, 55, 60, 0) : Shade(140, 145, 155, noise / 2));
+    }
+    case 7: // Hazard stripes
+        return ((x + y) / 8) & 1 ? Shade(230, 190, 20, noise / 2) : Shade(30, 30, 30, noise / 2);
+    case 8: // Purple xor pattern
+        return Shade(((x ^ y) * 4) & 255, 40, 160, noise / 2);
+    case 9: // Sandstone
+        return Shade(200, 170, 110, noise + (y % 12 == 0 ? -40 : 0));
+    default: { // Blue panels, close to the old flat wall colour
+        bool seam = x % 32 == 0 || y % 32 == 0;
+        return seam ? Shade(0, 80, 170, 0) : Shade(0, 121, 241, noise / 2);
+    }
+    }
+}
+
+bool TextureAtlasGenerate(TextureAtlas* atlas) {
+    *atlas = (TextureAtlas){0};
+    for (int level = 0; level < TEXTURE_LEVELS; level++) {
+        int size = TEXTURE_SIZE >> level;
+        atlas->levelOffset[level] = atlas->materialStride;
+        atlas->materialStride += (size_t)size * size;
+    }
+    atlas->bytes = atlas->materialStride * TEXTURE_MATERIALS * sizeof(Pixel);
+    atlas->texels = malloc(atlas->bytes);
+    if (!atlas->texels) return false;
+
+    for (int material = 0; material < TEXTURE_MATERIALS; material++) {
+        Pixel* base = atlas->texels + (size_t)material * atlas->materialStride;
+        for (int u = 0; u < TEXTURE_SIZE; u++) {
+            for (int v = 0; v < TEXTURE_SIZE; v++) base[u * TEXTURE_SIZE + v] = GenerateTexel(material, u, v);
+        }
+
+        // Each mip averages 2x2 texels of the one above it
+        for (int level = 1; level < TEXTURE_LEVELS; level++) {
+            const Pixel* src = base + atlas->levelOffset[level - 1];
+            Pixel* dst = base + atlas->levelOffset[level];
+            int srcSize = TEXTURE_SIZE >> (level - 1);
+            int size = srcSize / 2;
+            for (int u = 0; u < size; u++) {
+                for (int v = 0; v < size; v++) {
+                    const Pixel quad[4] = {src[(2 * u) * srcSize + 2 * v], src[(2 * u) * srcSize + 2 * v + 1],
+                                           src[(2 * u + 1) * srcSize + 2 * v], src[(2 * u + 1) * srcSize + 2 * v + 1]};
+                    uint32_t r = 0, g = 0, b = 0;
+                    for (int i = 0; i < 4; i++) {
+                        r += quad[i] & 0xFF;
+                        g += (quad[i] >> 8) & 0xFF;
+                        b += (quad[i] >> 16) & 0xFF;
+                    }
+                    dst[u * size + v] = PIXEL_RGBA((r + 2) / 4, (g + 2) / 4, (b + 2) / 4, 255);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void TextureAtlasFree(TextureAtlas* atlas) {
+    free(atlas->texels);
+    *atlas = (TextureAtlas){0};
+}
+
+int TextureAtlasSelectLevel(float columnHeight) {
+    int level = 0;
+    while (level + 1 < TEXTURE_LEVELS && (float)(TEXTURE_SIZE >> (level + 1)) >= columnHeight) level++;
+    return level;
+}
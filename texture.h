@@ -0,0 +1,34 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include "framebuffer.h"
+#include <stddef.h>
+
+// Square wall textures for every material, each with a full mip chain, in one
+// allocation. Texels are stored column-major (texels[u * size + v]) so drawing
+// a wall column reads one contiguous run from the selected mip.
+#define TEXTURE_SIZE_SHIFT 6
+#define TEXTURE_SIZE (1 << TEXTURE_SIZE_SHIFT)
+#define TEXTURE_LEVELS (TEXTURE_SIZE_SHIFT + 1)
+#define TEXTURE_MATERIALS 10
+
+typedef struct {
+    Pixel* texels;
+    size_t levelOffset[TEXTURE_LEVELS]; // Start of each mip within one material
+    size_t materialStride; // Texels per material, all mips included
+    size_t bytes;
+} TextureAtlas;
+
+// Fills the atlas with built-in procedural textures, one per material ID
+bool TextureAtlasGenerate(TextureAtlas* atlas);
+void TextureAtlasFree(TextureAtlas* atlas);
+
+// Mip whose size is the smallest one still at least columnHeight texels tall
+int TextureAtlasSelectLevel(float columnHeight);
+
+static inline const Pixel* TextureAtlasColumn(const TextureAtlas* atlas, int material, int level, int u) {
+    return atlas->texels + (size_t)(material % TEXTURE_MATERIALS) * atlas->materialStride + atlas->levelOffset[level] +
+           ((size_t)u << (TEXTURE_SIZE_SHIFT - level));
+}
+
+#endif
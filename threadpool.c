@@ -0,0 +1,151 @@
+#define _GNU_SOURCE
+#include "threadpool.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define MIN_CHUNK 16
+
+struct ThreadPool {
+    int threadCount;
+    pthread_t* workers;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    unsigned generation; // Bumped for every ThreadPoolRun, guarded by lock
+    bool quit;
+    bool pinThreads;
+
+    // Current job
+    ThreadPoolTask task;
+    void* context;
+    int count;
+    int chunk;
+    atomic_int nextBegin;
+    atomic_int busyWorkers;
+};
+
+int GetOnlineCoreCount(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+static void RunChunks(ThreadPool* pool) {
+    for (;;) {
+        int begin = atomic_fetch_add(&pool->nextBegin, pool->chunk);
+        if (begin >= pool->count) return;
+        int end = begin + pool->chunk < pool->count ? begin + pool->chunk : pool->count;
+        pool->task(pool->context, begin, end);
+    }
+}
+
+static void* WorkerMain(void* arg) {
+    ThreadPool* pool = arg;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->quit && pool->generation == seen) pthread_cond_wait(&pool->wake, &pool->lock);
+        if (pool->quit) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        RunChunks(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if (atomic_fetch_sub(&pool->busyWorkers, 1) == 1) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool* ThreadPoolCreate(int threadCount, bool pinThreads) {
+    int cores = GetOnlineCoreCount();
+    if (threadCount <= 0) threadCount = cores;
+
+    ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+    pool->threadCount = threadCount;
+    pool->pinThreads = pinThreads;
+    pool->workers = calloc(threadCount, sizeof(pthread_t));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    // Worker i runs on core i; core 0 is left for the thread that calls ThreadPoolRun
+    for (int i = 1; i < threadCount; i++) {
+        if (pthread_create(&pool->workers[i], NULL, WorkerMain, pool) != 0) {
+            pool->threadCount = i;
+            break;
+        }
+        if (pinThreads) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(i % cores, &set);
+            pthread_setaffinity_np(pool->workers[i], sizeof(set), &set);
+        }
+    }
+    return pool;
+}
+
+void ThreadPoolPinCaller(const ThreadPool* pool) {
+    if (!pool || !pool->pinThreads) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(0, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+void ThreadPoolDestroy(ThreadPool* pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 1; i < pool->threadCount; i++) pthread_join(pool->workers[i], NULL);
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+int ThreadPoolSize(const ThreadPool* pool) {
+    return pool ? pool->threadCount : 1;
+}
+
+void ThreadPoolRun(ThreadPool* pool, ThreadPoolTask task, void* context, int count) {
+    if (count <= 0) return;
+    if (!pool || pool->threadCount == 1 || count <= MIN_CHUNK) {
+        task(context, 0, count);
+        return;
+    }
+
+    // About four chunks per thread keeps the tail short without much contention
+    int chunk = count / (pool->threadCount * 4);
+    if (chunk < MIN_CHUNK) chunk = MIN_CHUNK;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->context = context;
+    pool->count = count;
+    pool->chunk = chunk;
+    atomic_store(&pool->nextBegin, 0);
+    atomic_store(&pool->busyWorkers, pool->threadCount - 1);
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    RunChunks(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while (atomic_load(&pool->busyWorkers) > 0) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,26 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stdbool.h>
+
+// Persistent workers that split an index range [0, count) into chunks. The
+// calling thread works on chunks too and ThreadPoolRun returns once every
+// chunk is done.
+typedef void (*ThreadPoolTask)(void* context, int begin, int end);
+
+typedef struct ThreadPool ThreadPool;
+
+// threadCount includes the thread that calls ThreadPoolRun; 0 means one per
+// online core. Pinned workers take cores 1.. and leave core 0 to that thread.
+ThreadPool* ThreadPoolCreate(int threadCount, bool pinThreads);
+// Pins the calling thread to core 0 when the pool pins its workers. Call it
+// from the thread that runs the pool's jobs; threads it starts afterwards
+// inherit the pin, so start those first.
+void ThreadPoolPinCaller(const ThreadPool* pool);
+void ThreadPoolDestroy(ThreadPool* pool);
+int ThreadPoolSize(const ThreadPool* pool);
+void ThreadPoolRun(ThreadPool* pool, ThreadPoolTask task, void* context, int count);
+
+int GetOnlineCoreCount(void);
+
+#endif
@@ -0,0 +1,206 @@
+#include "viewcache.h"
+#include "clock.h"
+#include "render.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Distances are stored in 1/1024 units in the low 15 bits, side in the top bit
+#define VIEW_DISTANCE_SCALE 1024.0f
+#define VIEW_CODE_NONE 0x7FFF
+#define VIEW_CODE_OUTSIDE 0x7FFE
+#define VIEW_CODE_MAX_DISTANCE 0x7FFD
+
+static uint16_t EncodeHit(const RayHit* hit) {
+    uint16_t side = hit->side ? 0x8000 : 0;
+    if (hit->kind == RAY_HIT_NONE) return VIEW_CODE_NONE;
+    if (hit->kind == RAY_HIT_OUTSIDE) return side | VIEW_CODE_OUTSIDE;
+
+    float code = roundf(hit->distance * VIEW_DISTANCE_SCALE);
+    if (code > VIEW_CODE_MAX_DISTANCE) code = VIEW_CODE_MAX_DISTANCE;
+    return side | (uint16_t)code;
+}
+
+static RayHit DecodeHit(uint16_t packed, float maxDistance) {
+    RayHit hit = {RAY_HIT_WALL, 0.0f, packed >> 15, -1, -1, 0.0f};
+    uint16_t code = packed & 0x7FFF;
+    if (code == VIEW_CODE_NONE) {
+        hit.kind = RAY_HIT_NONE;
+        hit.distance = maxDistance;
+    } else if (code == VIEW_CODE_OUTSIDE) {
+        hit.kind = RAY_HIT_OUTSIDE;
+    } else {
+        hit.distance = code / VIEW_DISTANCE_SCALE;
+    }
+    return hit;
+}
+
+bool ViewCacheInit(ViewCache* cache, const Level* level, int screenWidth, float maxDistance) {
+    const Map* map = &level->map;
+    size_t cells = (size_t)map->width * map->height;
+    *cache = (ViewCache){.level = level, .maxDistance = maxDistance, .editsSeen = level->editCount};
+    if (!(maxDistance > 0.0f) || maxDistance * VIEW_DISTANCE_SCALE > VIEW_CODE_MAX_DISTANCE) {
+        fprintf(stderr, "view cache: view distance %.1f does not fit the packed distances\n", maxDistance);
+        return false;
+    }
+
+    // Sized before anything is allocated: a large map's table runs to terabytes
+    uint64_t freeCells = 0;
+    for (int y = 0; y < map->height; y++) {
+        for (int x = 0; x < map->width; x++) freeCells += !MapIsSolid(map, x, y);
+    }
+    uint64_t states = freeCells * 4;
+    uint64_t bytes = sizeof(int) * (uint64_t)cells;
+    for (int v = 0; v < VIEW_CACHE_VARIANTS; v++) {
+        bytes += (sizeof(uint16_t) * (uint64_t)GetViewRayCount(screenWidth, v == 0) + 1) * states;
+    }
+    if (bytes > VIEW_CACHE_MAX_BYTES) {
+        fprintf(stderr, "view cache: %" PRIu64 " free cells need %.1f MiB, over the %.0f MiB limit\n", freeCells,
+                bytes / (1024.0 * 1024.0), VIEW_CACHE_MAX_BYTES / (1024.0 * 1024.0));
+        return false;
+    }
+
+    cache->cellIndex = malloc(sizeof(int) * cells);
+    if (!cache->cellIndex) return false;
+    for (int y = 0; y < map->height; y++) {
+        for (int x = 0; x < map->width; x++) {
+            cache->cellIndex[(size_t)y * map->width + x] = MapIsSolid(map, x, y) ? -1 : cache->freeCells++;
+        }
+    }
+    cache->bytes = sizeof(int) * cells;
+
+    for (int v = 0; v < VIEW_CACHE_VARIANTS; v++) {
+        int numRays = GetViewRayCount(screenWidth, v == 0);
+        if (!RayTableInit(&cache->tables[v], numRays, FOV)) goto fail;
+        cache->columns[v] = malloc(sizeof(uint16_t) * (size_t)states * numRays);
+        cache->filled[v] = calloc(states, 1);
+        if (!cache->columns[v] || !cache->filled[v]) goto fail;
+        cache->bytes += sizeof(uint16_t) * (size_t)states * numRays + states;
+    }
+    return true;
+
+fail:
+    ViewCacheFree(cache);
+    return false;
+}
+
+void ViewCacheFree(ViewCache* cache) {
+    for (int v = 0; v < VIEW_CACHE_VARIANTS; v++) {
+        RayTableFree(&cache->tables[v]);
+        free(cache->columns[v]);
+        free(cache->filled[v]);
+    }
+    free(cache->cellIndex);
+    *cache = (ViewCache){0};
+}
+
+static void BuildState(ViewCache* cache, int variant, int state, const Player* player, RayHit* hits) {
+    const RayTable* table = &cache->tables[variant];
+    uint16_t* dst = cache->columns[variant] + (size_t)state * table->numRays;
+
+    CastView(cache->level, player, table, CASTER_DDA, cache->maxDistance, hits, NULL);
+    for (int i = 0; i < table->numRays; i++) dst[i] = EncodeHit(&hits[i]);
+    cache->filled[variant][state] = 1;
+    cache->statesBuilt++;
+}
+
+// Whether any ray of the view from (x, y) along heading can reach cell (editX, editY)
+static bool CanViewReach(int x, int y, int heading, int editX, int editY, float maxDistance) {
+    float forwardX, forwardY, backwardX, backwardY;
+    GetMovementDirections(heading * 90.0f, &forwardX, &forwardY, &backwardX, &backwardY);
+    float dx = (float)(editX - x), dy = (float)(editY - y);
+    float forward = dx * forwardX + dy * forwardY;
+    float lateral = fabsf(dx * forwardY - dy * forwardX);
+    // Headings are axis aligned, so the edited cell spans forward +- 0.5 and lateral +- 0.5
+    return forward + 0.5f > 0.0f && forward - 0.5f <= maxDistance &&
+           lateral - 0.5f <= (forward + 0.5f) * tanf(FOV * 0.5f * DEG2RAD) + 0.01f;
+}
+
+// Drops the views that can see a cell edited since the last sync
+static void SyncEdits(ViewCache* cache) {
+    const Level* level = cache->level;
+    const Map* map = &level->map;
+    int reach = (int)ceilf(cache->maxDistance / cosf(FOV * 0.5f * DEG2RAD)) + 1;
+    for (; cache->editsSeen != level->editCount; cache->editsSeen++) {
+        LevelEdit edit;
+        if (!LevelGetEdit(level, cache->editsSeen, &edit)) {
+            // Too far behind to know what changed
+            for (int v = 0; v < VIEW_CACHE_VARIANTS; v++) memset(cache->filled[v], 0, (size_t)cache->freeCells * 4);
+            cache->statesInvalidated += cache->freeCells * 4;
+            cache->editsSeen = level->editCount;
+            return;
+        }
+        int x0 = edit.x - reach < 0 ? 0 : edit.x - reach;
+        int y0 = edit.y - reach < 0 ? 0 : edit.y - reach;
+        int x1 = edit.x + reach >= map->width ? map->width - 1 : edit.x + reach;
+        int y1 = edit.y + reach >= map->height ? map->height - 1 : edit.y + reach;
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                int slot = cache->cellIndex[(size_t)y * map->width + x];
+                if (slot < 0) continue;
+                for (int heading = 0; heading < 4; heading++) {
+                    if (!CanViewReach(x, y, heading, edit.x, edit.y, cache->maxDistance)) continue;
+                    for (int v = 0; v < VIEW_CACHE_VARIANTS; v++) cache->filled[v][slot * 4 + heading] = 0;
+                    cache->statesInvalidated++;
+                }
+            }
+        }
+    }
+}
+
+void ViewCacheBuildAll(ViewCache* cache) {
+    const Map* map = &cache->level->map;
+    double start = GetMonotonicSeconds();
+    RayHit* hits = malloc(sizeof(RayHit) * cache->tables[1].numRays);
+    if (!hits) return;
+
+    SyncEdits(cache);
+    for (int y = 0; y < map->height; y++) {
+        for (int x = 0; x < map->width; x++) {
+            int slot = cache->cellIndex[(size_t)y * map->width + x];
+            if (slot < 0 || MapIsSolid(map, x, y)) continue;
+            for (int heading = 0; heading < 4; heading++) {
+                Player player = {.pos = {(float)x, (float)y}, .angle = heading * 90.0f};
+                for (int v = 0; v < VIEW_CACHE_VARIANTS; v++) {
+                    if (!cache->filled[v][slot * 4 + heading]) BuildState(cache, v, slot * 4 + heading, &player, hits);
+                }
+            }
+        }
+    }
+    free(hits);
+    cache->buildSeconds += GetMonotonicSeconds() - start;
+}
+
+bool ViewCacheLookup(ViewCache* cache, const Player* player, bool showDebugMap, float maxDistance, RayHit* hits) {
+    const Map* map = &cache->level->map;
+    if (maxDistance != cache->maxDistance) return false;
+    int heading = GetHeadingIndex(player->angle);
+    int x = (int)player->pos.x;
+    int y = (int)player->pos.y;
+    if (heading < 0 || player->pos.x != (float)x || player->pos.y != (float)y) return false;
+    if (!IsPointInMap(map, x, y) || MapIsSolid(map, x, y)) return false;
+    int slot = cache->cellIndex[(size_t)y * map->width + x];
+    if (slot < 0) return false;
+    SyncEdits(cache);
+
+    int variant = showDebugMap ? 0 : 1;
+    int state = slot * 4 + heading;
+    const RayTable* table = &cache->tables[variant];
+    if (!cache->filled[variant][state]) {
+        double start = GetMonotonicSeconds();
+        BuildState(cache, variant, state, player, hits);
+        cache->buildSeconds += GetMonotonicSeconds() - start;
+    }
+
+    const uint16_t* src = cache->columns[variant] + (size_t)state * table->numRays;
+    for (int i = 0; i < table->numRays; i++) hits[i] = DecodeHit(src[i], cache->maxDistance);
+    return true;
+}
+
+void ViewCachePrintStats(const ViewCache* cache) {
+    printf("view cache: %d free cells, %d/%d views built in %.3f ms, %d dropped by edits, %.1f KiB\n",
+           cache->freeCells, cache->statesBuilt, cache->freeCells * 4 * VIEW_CACHE_VARIANTS,
+           cache->buildSeconds * 1000.0, cache->statesInvalidated, cache->bytes / 1024.0);
+}
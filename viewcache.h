@@ -0,0 +1,49 @@
+#ifndef VIEWCACHE_H
+#define VIEWCACHE_H
+
+#include "raycast.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Discrete-step mode only has free cells x 4 headings x 2 ray counts as
+// possible views, so each one can be cast once and replayed from a table.
+#define VIEW_CACHE_VARIANTS 2
+// Larger tables are refused; this also keeps state indices inside int
+#define VIEW_CACHE_MAX_BYTES ((uint64_t)1 << 30)
+
+typedef enum { VIEW_CACHE_OFF, VIEW_CACHE_LAZY, VIEW_CACHE_EAGER } ViewCacheMode;
+
+typedef struct {
+    const Level* level;
+    float maxDistance; // Views are cast out to this and only looked up for it
+    RayTable tables[VIEW_CACHE_VARIANTS];
+    int* cellIndex; // Map cell -> free cell slot, -1 for cells that were walls at init
+    int freeCells;
+    uint16_t* columns[VIEW_CACHE_VARIANTS]; // [slot * 4 + heading][numRays], packed distance + side
+    uint8_t* filled[VIEW_CACHE_VARIANTS]; // [slot * 4 + heading]
+    int statesBuilt;
+    int statesInvalidated;
+    uint32_t editsSeen; // Level edits already applied
+    double buildSeconds;
+    size_t bytes;
+} ViewCache;
+
+// Variants are the two ray counts produced by GetViewRayCount for screenWidth.
+// Views are cast with DDA out to maxDistance, which must fit the packed
+// distances (under 32).
+bool ViewCacheInit(ViewCache* cache, const Level* level, int screenWidth, float maxDistance);
+void ViewCacheFree(ViewCache* cache);
+void ViewCacheBuildAll(ViewCache* cache);
+
+// Fills hits for the given view, casting and storing it first if needed.
+// Returns false when the view is not cacheable (off-grid position or heading,
+// a cell opened after init, or a view distance other than the cache's). Views
+// that can see a cell edited since the last call are dropped first.
+bool ViewCacheLookup(ViewCache* cache, const Player* player, bool showDebugMap, float maxDistance, RayHit* hits);
+// Cached views are DDA hits, which the march and fixed-point casters do not reproduce
+static inline bool ViewCacheMatchesCaster(CasterKind caster) {
+    return caster != CASTER_MARCH && caster != CASTER_FIXED;
+}
+void ViewCachePrintStats(const ViewCache* cache);
+
+#endif
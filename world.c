@@ -0,0 +1,167 @@
+#include "world.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static const char defaultMap[MAP_HEIGHT][MAP_WIDTH] = {{'w', 'w', 'w', 'w', 'w', 'w', 'w', 'w'},
+                                                       {'w', '0', '0', '0', '0', '0', '0', 'w'},
+                                                       {'w', '0', 'w', '0', 'w', '0', '0', 'w'},
+                                                       {'w', '0', '0', '0', '0', 'w', '0', 'w'},
+                                                       {'w', '0', 'w', '0', 'w', '0', '0', 'w'},
+                                                       {'w', '0', '0', 'w', '0', '0', '0', 'w'},
+                                                       {'w', '0', '0', '0', '0', '0', '0', 'w'},
+                                                       {'w', 'w', 'w', 'w', 'w', 'w', 'w', 'w'}};
+
+bool MapInit(Map* map, int width, int height, bool withMaterials) {
+    *map = (Map){.width = width, .height = height, .stride = (width + 2 + 63) / 64, .spawnX = 1, .spawnY = 1};
+    size_t words = (size_t)(height + 2) * map->stride;
+    map->bits = malloc(words * sizeof(uint64_t));
+    if (!map->bits) return false;
+    if (withMaterials) {
+        map->materials = calloc((size_t)width * height, 1);
+        if (!map->materials) {
+            MapFree(map);
+            return false;
+        }
+    }
+
+    // Start fully solid, then clear bits 1..width of every interior row
+    memset(map->bits, 0xFF, words * sizeof(uint64_t));
+    for (int y = 0; y < height; y++) {
+        uint64_t* row = map->bits + (size_t)(y + 1) * map->stride;
+        for (int bit = 1; bit <= width;) {
+            int count = 64 - (bit & 63);
+            if (count > width + 1 - bit) count = width + 1 - bit;
+            uint64_t mask = count == 64 ? ~(uint64_t)0 : (((uint64_t)1 << count) - 1) << (bit & 63);
+            row[bit >> 6] &= ~mask;
+            bit += count;
+        }
+    }
+    return true;
+}
+
+void MapFree(Map* map) {
+    if (map->mapping) {
+        munmap(map->mapping, map->mappingSize);
+    } else {
+        free(map->bits);
+        free(map->materials);
+    }
+    *map = (Map){0};
+}
+
+bool MapLoadChars(Map* map, const char* cells, int width, int height) {
+    if (!MapInit(map, width, height, false)) return false;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (cells[y * width + x] == 'w') MapSetSolid(map, x, y, true);
+        }
+    }
+    return true;
+}
+
+bool MapLoadDefault(Map* map) {
+    return MapLoadChars(map, &defaultMap[0][0], MAP_WIDTH, MAP_HEIGHT);
+}
+
+// Scatters short wall segments over an open field; density is the fraction of
+// cells that end up solid. The same seed always gives the same map.
+bool MapGenerateSparse(Map* map, int width, int height, float density, uint32_t seed) {
+    if (!MapInit(map, width, height, true)) return false;
+
+    uint32_t state = seed ? seed : 1;
+    int segments = (int)((double)width * height * density / 4.0);
+    for (int i = 0; i < segments; i++) {
+        // xorshift32, three draws per segment: position, then orientation and material
+        state ^= state << 13, state ^= state >> 17, state ^= state << 5;
+        int x = state % width;
+        state ^= state << 13, state ^= state >> 17, state ^= state << 5;
+        int y = state % height;
+        state ^= state << 13, state ^= state >> 17, state ^= state << 5;
+        bool vertical = state & 1;
+        uint8_t material = (uint8_t)(1 + (state >> 1) % 9);
+        for (int j = 0; j < 4; j++) {
+            int cellX = vertical ? x : x + j;
+            int cellY = vertical ? y + j : y;
+            if (cellX < width && cellY < height) {
+                MapSetSolid(map, cellX, cellY, true);
+                map->materials[(size_t)cellY * width + cellX] = material;
+            }
+        }
+    }
+
+    map->spawnX = width / 2;
+    map->spawnY = height / 2;
+    MapSetSolid(map, map->spawnX, map->spawnY, false);
+    return true;
+}
+
+void MapSetSolid(Map* map, int x, int y, bool solid) {
+    unsigned bit = (unsigned)(x + 1);
+    uint64_t* word = &map->bits[(size_t)(y + 1) * map->stride + (bit >> 6)];
+    if (solid) {
+        *word |= (uint64_t)1 << (bit & 63);
+    } else {
+        *word &= ~((uint64_t)1 << (bit & 63));
+    }
+}
+
+// FNV-1a over the occupancy rows, border words included
+uint64_t MapHashBits(const Map* map) {
+    uint64_t hash = 14695981039346656037u;
+    size_t words = (size_t)(map->height + 2) * map->stride;
+    hash = (hash ^ (uint64_t)map->width) * 1099511628211u;
+    hash = (hash ^ (uint64_t)map->height) * 1099511628211u;
+    for (size_t i = 0; i < words; i++) hash = (hash ^ map->bits[i]) * 1099511628211u;
+    return hash;
+}
+
+bool IsPointInMap(const Map* map, float x, float y) {
+    return x >= 0 && x < map->width && y >= 0 && y < map->height;
+}
+
+void GetMovementDirections(float angle, float* forwardX, float* forwardY, float* backwardX, float* backwardY) {
+    // Define forward and backward directions based on angle (YOUR CORRECTED VERSION)
+    if (angle == 0.0f) { // East
+        *forwardX = 1.0f;
+        *forwardY = 0.0f;
+        *backwardX = -1.0f;
+        *backwardY = 0.0f;
+    } else if (angle == 90.0f) { // North (up, -Y)
+        *forwardX = 0.0f;
+        *forwardY = 1.0f; // Forward is up (decreasing Y) // fixed
+        *backwardX = 0.0f;
+        *backwardY = -1.0f; // Backward is down (increasing Y) // fixed
+    } else if (angle == 180.0f) { // West
+        *forwardX = -1.0f;
+        *forwardY = 0.0f;
+        *backwardX = 1.0f;
+        *backwardY = 0.0f;
+    } else if (angle == 270.0f) { // South (down, +Y)
+        *forwardX = 0.0f;
+        *forwardY = -1.0f; // Forward is down (increasing Y) // fixed
+        *backwardX = 0.0f;
+        *backwardY = 1.0f; // Backward is up (decreasing Y) // fixed
+    }
+}
+
+bool StepPlayer(Player* player, const Map* map, bool forward) {
+    float forwardX = 0.0f, forwardY = 0.0f, backwardX = 0.0f, backwardY = 0.0f;
+    GetMovementDirections(player->angle, &forwardX, &forwardY, &backwardX, &backwardY);
+    float newX = player->pos.x + (forward ? forwardX : backwardX) * CELL_SIZE;
+    float newY = player->pos.y + (forward ? forwardY : backwardY) * CELL_SIZE;
+    if (!IsPointInMap(map, newX, newY) || MapIsSolid(map, (int)newX, (int)newY)) return false;
+    player->pos.x = newX;
+    player->pos.y = newY;
+    return true;
+}
+
+void TurnPlayer(Player* player, bool left) {
+    if (left) {
+        player->angle += 90.0f;
+        if (player->angle >= 360.0f) player->angle -= 360.0f;
+    } else {
+        player->angle -= 90.0f;
+        if (player->angle < 0.0f) player->angle += 360.0f;
+    }
+}
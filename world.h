@@ -0,0 +1,67 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Size of the built-in layout
+#define MAP_WIDTH 8
+#define MAP_HEIGHT 8
+#define CELL_SIZE 1.0f
+#define PLAYER_OFFSET 0.5f
+
+typedef struct {
+    float x;
+    float y;
+} Vec2;
+
+typedef struct {
+    Vec2 pos; // Integer grid position (0, 1, 2, etc.)
+    float angle; // Only 0, 90, 180, 270
+    float speed; // Unused, kept for potential future use
+} Player;
+
+// Occupancy grid, 1 bit per cell (1 = solid). Rows carry a one-cell solid
+// border on every side, so cells -1..width and -1..height can be read without
+// bounds checks and a ray that starts inside always stops at the border.
+typedef struct {
+    int width;
+    int height;
+    int stride; // 64-bit words per padded row
+    uint64_t* bits; // Cell (x, y) is bit x + 1 of row y + 1
+    uint8_t* materials; // Optional material ID per cell (width * height), NULL = all 0
+    int spawnX;
+    int spawnY;
+    void* mapping; // Set when bits/materials point into a memory-mapped map file
+    size_t mappingSize;
+} Map;
+
+bool MapInit(Map* map, int width, int height, bool withMaterials);
+void MapFree(Map* map);
+// Reads a width x height char grid where 'w' marks walls
+bool MapLoadChars(Map* map, const char* cells, int width, int height);
+bool MapLoadDefault(Map* map);
+bool MapGenerateSparse(Map* map, int width, int height, float density, uint32_t seed);
+void MapSetSolid(Map* map, int x, int y, bool solid);
+// Identifies an occupancy, for files that are only valid for one map
+uint64_t MapHashBits(const Map* map);
+
+static inline bool MapIsSolid(const Map* map, int x, int y) {
+    unsigned bit = (unsigned)(x + 1);
+    return (map->bits[(size_t)(y + 1) * map->stride + (bit >> 6)] >> (bit & 63)) & 1;
+}
+
+static inline uint8_t MapGetMaterial(const Map* map, int x, int y) {
+    if (!map->materials || x < 0 || x >= map->width || y < 0 || y >= map->height) return 0;
+    return map->materials[(size_t)y * map->width + x];
+}
+
+bool IsPointInMap(const Map* map, float x, float y);
+void GetMovementDirections(float angle, float* forwardX, float* forwardY, float* backwardX, float* backwardY);
+// One grid step along the heading (forward) or against it; walls and the map edge block it
+bool StepPlayer(Player* player, const Map* map, bool forward);
+// Discrete 90-degree turn
+void TurnPlayer(Player* player, bool left);
+
+#endif